@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "csync.h"
+
+/**
+ * csynccheck - hold the vga board's sync measurement filter to what csync_task relies on
+ *
+ * The cpu only ever flips an input's polarity or changes the broad pulse length when CSYNC_AGREE measurements in a
+ * row say so. These feed it the sort of thing sync_measure pushes when the source is steady, when it's the wrong way
+ * round, and when a sync goes missing and the 16 bit counts come out as junk.
+ */
+
+// a 15.7kHz line with a 4.7us hsync, in sync_measure counts
+#define LINE_ACTIVE 294
+#define LINE_IDLE   3675
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+/**
+ * A steady line settles after CSYNC_AGREE measurements, wobble and all, and stays settled
+ */
+static void check_settle(void)
+{
+    csync_filter f;
+    csync_filter_reset(&f);
+
+    for (int i = 0; i < CSYNC_AGREE - 1; i++) {
+        CHECK(csync_filter_push(&f, LINE_ACTIVE + (i & 1), LINE_IDLE - (i & 1)) == CSYNC_KEEP);
+    }
+    for (int i = 0; i < 100; i++) {
+        CHECK(csync_filter_push(&f, LINE_ACTIVE + (i & 1), LINE_IDLE + (i % 3) - 1) == CSYNC_LINE);
+    }
+}
+
+/**
+ * Backwards polarity needs CSYNC_AGREE in a row to flip, and starts the count again afterwards
+ */
+static void check_flip(void)
+{
+    csync_filter f;
+    csync_filter_reset(&f);
+
+    for (int i = 0; i < CSYNC_AGREE - 1; i++) {
+        CHECK(csync_filter_push(&f, LINE_IDLE, LINE_ACTIVE) == CSYNC_KEEP);
+    }
+    CHECK(csync_filter_push(&f, LINE_IDLE, LINE_ACTIVE) == CSYNC_FLIP);
+
+    // one straddling the flip and then the right way round
+    CHECK(csync_filter_push(&f, LINE_IDLE / 2, LINE_ACTIVE) == CSYNC_KEEP);
+    for (int i = 0; i < CSYNC_AGREE - 1; i++) {
+        CHECK(csync_filter_push(&f, LINE_ACTIVE, LINE_IDLE) == CSYNC_KEEP);
+    }
+    CHECK(csync_filter_push(&f, LINE_ACTIVE, LINE_IDLE) == CSYNC_LINE);
+}
+
+/**
+ * The odd backwards looking measurement among good ones never flips anything
+ */
+static void check_stray_inverted(void)
+{
+    csync_filter f;
+    csync_filter_reset(&f);
+
+    int flips = 0;
+    for (int i = 0; i < 1000; i++) {
+        bool stray = (i % CSYNC_AGREE) == 0;
+        if (csync_filter_push(&f, stray ? LINE_IDLE : LINE_ACTIVE, stray ? LINE_ACTIVE : LINE_IDLE) == CSYNC_FLIP) {
+            flips++;
+        }
+    }
+    CHECK(flips == 0);
+}
+
+/**
+ * A missing sync wraps the 16 bit counts, so what comes out is effectively random. It mustn't reach the broad pulses,
+ * and the line already settled is only replaced once the source is back and steady
+ */
+static void check_junk(void)
+{
+    csync_filter f;
+    csync_filter_reset(&f);
+    for (int i = 0; i < CSYNC_AGREE; i++) {
+        csync_filter_push(&f, LINE_ACTIVE, LINE_IDLE);
+    }
+
+    srand(3);
+    int lines = 0, flips = 0;
+    for (int i = 0; i < 10000; i++) {
+        csync_action action = csync_filter_push(&f, rand() & 0xFFFF, rand() & 0xFFFF);
+        if (action == CSYNC_LINE) lines++;
+        if (action == CSYNC_FLIP) flips++;
+    }
+    CHECK(lines == 0);
+    // random pairs look backwards half the time, so a run of them can get through, but nowhere near every time
+    CHECK(flips < 10000 / (1 << CSYNC_AGREE));
+
+    // back to a steady 31kHz source
+    int settled_after = -1;
+    for (int i = 0; i < 10 && settled_after < 0; i++) {
+        if (csync_filter_push(&f, 240, 1760) == CSYNC_LINE) settled_after = i + 1;
+    }
+    CHECK(settled_after > 0 && settled_after <= CSYNC_AGREE);
+}
+
+int main(void)
+{
+    check_settle();
+    check_flip();
+    check_stray_inverted();
+    check_junk();
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all csync filter checks passed\n");
+    return 0;
+}
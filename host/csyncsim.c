@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "csync.h"
+
+/**
+ * csyncsim - run a recorded sync waveform through the vga board's csync regeneration
+ *
+ * Uses the same polarity and broad pulse decisions as the firmware and a cycle level model of the csync PIO program,
+ * then reports how far csync lags hsync and what the vsync broad pulses and serrations look like.
+ *
+ * Waveforms are plain text, one line per change of either input, '#' starts a comment:
+ *
+ *   <time_ns> <hsync level> <vsync level>
+ *
+ * with levels as they are on the wire, so either polarity is fine. A logic analyser export trimmed to those three
+ * columns does the job.
+ *
+ * Exits non-zero if csync is ever more than a pixel late, misses an hsync leading edge, or with -e/-s, if the number
+ * of edges or serrations isn't what was expected, so a known waveform makes a regression test (see host/waveforms/).
+ */
+
+#define NS_PER_CYCLE (1000000000.0 / CSYNC_SYS_CLK_HZ)
+
+typedef struct {
+    uint64_t t_ns;
+    bool hsync;
+    bool vsync;
+} edge;
+
+typedef struct {
+    edge *data;
+    size_t len;
+    size_t cap;
+} edge_list;
+
+static bool load_waveform(const char *path, edge_list *out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    char line[256];
+    unsigned int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        unsigned long long t;
+        int h, v;
+        int fields = sscanf(line, "%llu %d %d", &t, &h, &v);
+        if (fields <= 0) continue;
+        if (fields != 3 || (out->len && t < out->data[out->len - 1].t_ns)) {
+            fprintf(stderr, "%s:%u: expected '<time_ns> <hsync> <vsync>' in time order\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+
+        if (out->len == out->cap) {
+            out->cap = out->cap ? out->cap * 2 : 4096;
+            out->data = realloc(out->data, out->cap * sizeof(edge));
+            if (!out->data) {
+                perror("realloc");
+                exit(1);
+            }
+        }
+        out->data[out->len++] = (edge){ .t_ns = t, .hsync = h != 0, .vsync = v != 0 };
+    }
+
+    fclose(f);
+    return true;
+}
+
+/**
+ * Total time each input spends high and low, in sync_measure counts
+ */
+static void duty(const edge_list *w, bool vsync, uint64_t *high, uint64_t *low)
+{
+    *high = 0;
+    *low = 0;
+    for (size_t i = 1; i < w->len; i++) {
+        uint64_t dt = w->data[i].t_ns - w->data[i - 1].t_ns;
+        bool level = vsync ? w->data[i - 1].vsync : w->data[i - 1].hsync;
+        if (level) {
+            *high += dt;
+        } else {
+            *low += dt;
+        }
+    }
+    *high = *high / (NS_PER_CYCLE * CSYNC_MEASURE_CYCLES);
+    *low = *low / (NS_PER_CYCLE * CSYNC_MEASURE_CYCLES);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [-p pixel_clock_hz] [-e edges] [-s serrations] [-v] waveform.txt\n"
+        "\n"
+        "  -p hz   pixel clock to hold the added delay to (default: 6700000, 320 wide at 15kHz)\n"
+        "  -e n    fail unless csync follows exactly this many hsync leading edges\n"
+        "  -s n    fail unless exactly this many serrations come out during vsync\n"
+        "  -v      print every csync edge\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    double pixel_hz = 6700000;
+    bool verbose = false;
+    long expect_edges = -1, expect_serrations = -1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:e:s:vh")) != -1) {
+        switch (opt) {
+        case 'p':
+            pixel_hz = atof(optarg);
+            break;
+        case 'e':
+            expect_edges = atol(optarg);
+            break;
+        case 's':
+            expect_serrations = atol(optarg);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    edge_list w = {0};
+    if (!load_waveform(argv[optind], &w)) return 1;
+    if (w.len < 2) {
+        fprintf(stderr, "%s: need at least two edges\n", argv[optind]);
+        return 1;
+    }
+
+    // same decisions the firmware makes, from the same sort of numbers
+    uint64_t h_high, h_low, v_high, v_low;
+    duty(&w, false, &h_high, &h_low);
+    duty(&w, true, &v_high, &v_low);
+    bool h_inv = csync_inverted(h_high, h_low);
+    bool v_inv = csync_inverted(v_high, v_low);
+
+    // average line, counting leading edges of the (normalised) hsync
+    size_t lines = 0;
+    for (size_t i = 1; i < w.len; i++) {
+        if ((w.data[i].hsync != h_inv) && (w.data[i - 1].hsync == h_inv)) lines++;
+    }
+    if (lines == 0) {
+        fprintf(stderr, "no hsync pulses found\n");
+        return 1;
+    }
+    uint64_t active = (h_inv ? h_low : h_high) / lines;
+    uint64_t idle = (h_inv ? h_high : h_low) / lines;
+    uint32_t broad = csync_broad_cycles(active, idle);
+
+    printf("hsync:              %s polarity, %zu lines, %.2f us line, %.2f us pulse\n", h_inv ? "negative" : "positive",
+        lines, (active + idle) * CSYNC_MEASURE_CYCLES * NS_PER_CYCLE / 1000, active * CSYNC_MEASURE_CYCLES * NS_PER_CYCLE / 1000);
+    printf("vsync:              %s polarity\n", v_inv ? "negative" : "positive");
+    printf("broad pulse:        %u cycles\n", broad);
+
+    csync_sim sim;
+    csync_sim_init(&sim);
+    csync_sim_put(&sim, broad);
+
+    // step the model a cycle at a time across the whole waveform
+    uint64_t start = w.data[0].t_ns;
+    uint64_t cycles = (w.data[w.len - 1].t_ns - start) / NS_PER_CYCLE;
+    size_t e = 0;
+    bool h = false, v = false, prev_h = false, prev_c = false, prev_v = false;
+    uint64_t h_edge = 0, c_rise = 0;
+    bool waiting = false;
+    uint64_t delay_max = 0, delay_sum = 0, delays = 0, missed = 0;
+    uint64_t serration_min = UINT64_MAX, serration_max = 0, serrations = 0, vsyncs = 0;
+
+    for (uint64_t c = 0; c < cycles; c++) {
+        uint64_t t = start + c * NS_PER_CYCLE;
+        while (e < w.len && w.data[e].t_ns <= t) {
+            h = w.data[e].hsync != h_inv;
+            v = w.data[e].vsync != v_inv;
+            e++;
+        }
+
+        bool out = csync_sim_step(&sim, h, v);
+
+        if (h && !prev_h) {
+            // if csync never rose for the last edge something's badly wrong, but don't let it skew the next one
+            if (waiting) missed++;
+            h_edge = c;
+            waiting = true;
+        }
+        if (v && !prev_v) vsyncs++;
+        if (out && !prev_c) {
+            c_rise = c;
+            if (waiting) {
+                uint64_t d = c - h_edge + 1; // counting the cycle the pin takes to change
+                if (d > delay_max) delay_max = d;
+                delay_sum += d;
+                delays++;
+                waiting = false;
+            }
+        }
+        if (!out && prev_c && v) {
+            // a serration, so how long since this broad pulse started
+            uint64_t broad_len = c - c_rise;
+            if (broad_len < serration_min) serration_min = broad_len;
+            if (broad_len > serration_max) serration_max = broad_len;
+            serrations++;
+        }
+        if (verbose && out != prev_c) {
+            printf("%llu %d\n", (unsigned long long)(t - start), out ? 0 : 1); // active low, like the pin
+        }
+
+        prev_h = h;
+        prev_v = v;
+        prev_c = out;
+    }
+
+    double pixel_ns = 1e9 / pixel_hz;
+    double max_ns = delay_max * NS_PER_CYCLE;
+    printf("hsync to csync:     mean %.1f ns, max %.1f ns over %llu edges\n",
+        delays ? delay_sum * NS_PER_CYCLE / delays : 0.0, max_ns, (unsigned long long)delays);
+    printf("missed hsync edges: %llu\n", (unsigned long long)missed);
+    printf("pixel clock:        %.1f ns, delay %s\n", pixel_ns, max_ns < pixel_ns ? "ok" : "TOO LONG");
+    printf("vsync:              %llu frames, %llu serrations, broad pulses %.2f - %.2f us\n",
+        (unsigned long long)vsyncs, (unsigned long long)serrations,
+        serrations ? serration_min * NS_PER_CYCLE / 1000 : 0.0, serrations ? serration_max * NS_PER_CYCLE / 1000 : 0.0);
+
+    free(w.data);
+
+    bool ok = max_ns < pixel_ns && missed == 0;
+    if (expect_edges >= 0 && delays != (uint64_t)expect_edges) {
+        fprintf(stderr, "expected %ld edges, got %llu\n", expect_edges, (unsigned long long)delays);
+        ok = false;
+    }
+    if (expect_serrations >= 0 && serrations != (uint64_t)expect_serrations) {
+        fprintf(stderr, "expected %ld serrations, got %llu\n", expect_serrations, (unsigned long long)serrations);
+        ok = false;
+    }
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "guncon.h"
+#include "link.h"
+
+/**
+ * guncheck - decode canned Guncon poll responses and carry them across the inter-board link
+ *
+ * Runs the same guncon_decode() the psx board does, then the same link_encode() and link_decoder the two boards use
+ * between them, and checks the stick board ends up with exactly the report the psx board built.
+ */
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// a Guncon poll response, with the buttons given active high the way they're written in guncon.h
+static void response(uint8_t *resp, uint16_t held, uint16_t x, uint16_t y)
+{
+    uint16_t raw = ~held;
+    uint8_t r[GUNCON_POLL_LEN] = { 0xFF, GUNCON_ID, 0x5A, raw & 0xFF, raw >> 8, x & 0xFF, x >> 8, y & 0xFF, y >> 8 };
+    memcpy(resp, r, sizeof(r));
+}
+
+/**
+ * Buttons land where guncon.h says, and positions span the whole axis
+ */
+static void check_decode(void)
+{
+    uint8_t resp[GUNCON_POLL_LEN];
+    buttons gun = BUTTONS_IDLE;
+
+    response(resp, 1 << 13, GUNCON_X_MIN, GUNCON_Y_MIN);
+    CHECK(guncon_decode(resp, sizeof(resp), &gun));
+    CHECK(gun.a && !gun.b && !gun.c && !gun.d);
+    CHECK(gun.x == 0 && gun.y == 0);
+
+    response(resp, (1 << 3) | (1 << 14), GUNCON_X_MAX, GUNCON_Y_MAX);
+    CHECK(guncon_decode(resp, sizeof(resp), &gun));
+    CHECK(!gun.a && gun.b && gun.c && !gun.d);
+    CHECK(gun.x == 255 && gun.y == 255);
+
+    response(resp, 0, (GUNCON_X_MIN + GUNCON_X_MAX) / 2, (GUNCON_Y_MIN + GUNCON_Y_MAX) / 2);
+    CHECK(guncon_decode(resp, sizeof(resp), &gun));
+    CHECK(gun.x >= 126 && gun.x <= 128);
+    CHECK(gun.y >= 126 && gun.y <= 128);
+
+    // beyond the calibrated picture clamps rather than wraps
+    response(resp, 0, GUNCON_X_MAX + 40, GUNCON_Y_MIN - 10);
+    CHECK(guncon_decode(resp, sizeof(resp), &gun));
+    CHECK(gun.x == 255 && gun.y == 0);
+}
+
+/**
+ * Offscreen holds the last position and says so, and comes back as soon as the gun sees the screen again
+ */
+static void check_offscreen(void)
+{
+    uint8_t resp[GUNCON_POLL_LEN];
+    buttons gun = BUTTONS_IDLE;
+
+    response(resp, 0, 200, 100);
+    guncon_decode(resp, sizeof(resp), &gun);
+    uint8_t x = gun.x, y = gun.y;
+
+    uint16_t offscreen_y[] = { 5, 10 };
+    for (int i = 0; i < 2; i++) {
+        response(resp, 1 << 13, 1, offscreen_y[i]);
+        CHECK(guncon_decode(resp, sizeof(resp), &gun));
+        CHECK(gun.d && gun.a);
+        CHECK(gun.x == x && gun.y == y);
+    }
+
+    response(resp, 0, 300, 200);
+    guncon_decode(resp, sizeof(resp), &gun);
+    CHECK(!gun.d);
+    CHECK(gun.x != x);
+}
+
+/**
+ * An empty port, a short read or some other controller all read as an idle gun
+ */
+static void check_not_a_guncon(void)
+{
+    const buttons idle = BUTTONS_IDLE;
+    uint8_t resp[GUNCON_POLL_LEN];
+    buttons gun;
+
+    // empty port, the data line just sits on its pull-up and nothing acks
+    memset(resp, 0xFF, sizeof(resp));
+    gun.a = 1;
+    CHECK(!guncon_decode(resp, 1, &gun));
+    CHECK(memcmp(&gun, &idle, sizeof(gun)) == 0);
+
+    // a digital pad with everything held
+    response(resp, 0xFFFF, 0, 0);
+    resp[1] = 0x41;
+    gun.a = 1;
+    CHECK(!guncon_decode(resp, 5, &gun));
+    CHECK(memcmp(&gun, &idle, sizeof(gun)) == 0);
+
+    // a gun that stopped answering part way
+    response(resp, 1 << 13, 200, 100);
+    CHECK(!guncon_decode(resp, GUNCON_POLL_LEN - 1, &gun));
+    CHECK(memcmp(&gun, &idle, sizeof(gun)) == 0);
+}
+
+/**
+ * What the psx board builds is what the stick board puts in its lightgun reports
+ */
+static void check_across_link(void)
+{
+    uint8_t resp[GUNCON_POLL_LEN];
+    buttons gun1 = BUTTONS_IDLE, gun2 = BUTTONS_IDLE;
+
+    response(resp, 1 << 13, 300, 150);
+    guncon_decode(resp, sizeof(resp), &gun1);
+    response(resp, 1 << 3, 1, 10);
+    guncon_decode(resp, sizeof(resp), &gun2);
+
+    // psx.c's link_task
+    uint8_t payload[sizeof(gun1) + sizeof(gun2)];
+    memcpy(payload, &gun1, sizeof(gun1));
+    memcpy(payload + sizeof(gun1), &gun2, sizeof(gun2));
+    uint8_t frame[LINK_MAX_FRAME];
+    size_t len = link_encode(7, payload, sizeof(payload), frame);
+
+    // stick.c's link_task
+    link_decoder dec;
+    link_decoder_init(&dec);
+    buttons rx1 = BUTTONS_IDLE, rx2 = BUTTONS_IDLE;
+    for (size_t i = 0; i < len; i++) {
+        if (link_decode_byte(&dec, frame[i]) && dec.len == sizeof(rx1) + sizeof(rx2)) {
+            memcpy(&rx1, dec.payload, sizeof(rx1));
+            memcpy(&rx2, dec.payload + sizeof(rx1), sizeof(rx2));
+        }
+    }
+
+    CHECK(dec.frames == 1);
+    CHECK(memcmp(&rx1, &gun1, sizeof(rx1)) == 0);
+    CHECK(memcmp(&rx2, &gun2, sizeof(rx2)) == 0);
+    CHECK(rx1.a && !rx1.d);
+    CHECK(rx2.b && rx2.d);
+}
+
+int main(void)
+{
+    check_decode();
+    check_offscreen();
+    check_not_a_guncon();
+    check_across_link();
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all guncon checks passed\n");
+    return 0;
+}
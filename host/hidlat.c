@@ -0,0 +1,499 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/wait.h>
+#include <linux/uhid.h>
+
+#include "buttons.h"
+#include "report_descriptor.h"
+#include "record.h"
+#include "usb_descriptors.h"
+
+/**
+ * hidlat - measure what the host actually sees from the stick board
+ *
+ * Live mode reads one of the stick board's hidraw nodes and reports polling interval, jitter and duplicate reports.
+ *
+ * Replay mode creates a uhid device with the exact same report descriptor as the firmware, plays a capture file into
+ * it on the capture's own timeline and reads it back through hidraw. Because we know when every report was meant to
+ * land, it can also report per-button press latency and any transitions that never made it to the host.
+ *
+ * Capture files are the text recordings described in record.h, so a dump from the stick board can be replayed as is.
+ * Only the accepted reports are played, e.g. "1500000 1 80800100" is player 1, stick centred, button a held,
+ * 1.5 seconds in. Raw expander reads are skipped since those never leave the board.
+ */
+
+#define REPORT_SIZE sizeof(buttons)
+#define NUM_INPUTS  16
+// how long to keep reading once the replay's emitter has sent its last report
+#define REPLAY_GRACE_MS 200
+
+typedef struct {
+    uint64_t t_us;
+    uint8_t report[REPORT_SIZE];
+} sample;
+
+typedef struct {
+    sample *data;
+    size_t len;
+    size_t cap;
+} sample_list;
+
+// names in the same bit order as the expander ports in stick.c
+static const char *input_names[NUM_INPUTS] = {
+    "up", "down", "left", "right",
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l"
+};
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stop = 1;
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void samples_push(sample_list *list, uint64_t t_us, const uint8_t *report)
+{
+    if (list->len == list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 1024;
+        list->data = realloc(list->data, list->cap * sizeof(sample));
+        if (!list->data) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    list->data[list->len].t_us = t_us;
+    memcpy(list->data[list->len].report, report, REPORT_SIZE);
+    list->len++;
+}
+
+/**
+ * Turn a report back into the 16 bit port state the firmware started from
+ * Directions come from the axes, everything else is the button bitfield shifted up past them
+ */
+static uint16_t report_state(const uint8_t *report)
+{
+    uint16_t state = 0;
+    uint8_t x = report[0];
+    uint8_t y = report[1];
+
+    if (y == 0) state |= 1 << 0;
+    if (y == 255) state |= 1 << 1;
+    if (x == 0) state |= 1 << 2;
+    if (x == 255) state |= 1 << 3;
+
+    state |= ((report[2] | (report[3] << 8)) & 0x0FFF) << 4;
+    return state;
+}
+
+/**
+ * Load every report for the given player out of a capture file
+ */
+static bool load_capture(const char *path, int player, sample_list *out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    char line[256];
+    unsigned int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+
+        record_event ev;
+        int ret = record_parse(line, &ev);
+        if (ret == 0) continue; // blank or comment
+        if (ret < 0) {
+            fprintf(stderr, "%s:%u: expected '<timestamp_us> <player> <%zu hex bytes>' or '<timestamp_us> <player> raw <4 hex>'\n", path, lineno, REPORT_SIZE);
+            fclose(f);
+            return false;
+        }
+        if (out->len && ev.t_us < out->data[out->len - 1].t_us) {
+            fprintf(stderr, "%s:%u: timestamps must not go backwards\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+        if (ev.kind == RECORD_ACCEPTED && ev.player == player) {
+            samples_push(out, ev.t_us, ev.data);
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+
+/**
+ * Read reports from a hidraw node, time-stamping each as it arrives
+ * Stops after count reports (0 for forever), on ctrl-c, or if emitter is set, grace_ms after that process has exited.
+ * The emitter is reaped here, and emitter is zeroed once it has been
+ */
+static void read_hidraw(int fd, size_t count, pid_t *emitter, int grace_ms, sample_list *out)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    uint64_t emitter_done_us = 0;
+
+    while (!stop && (count == 0 || out->len < count)) {
+        if (emitter && *emitter) {
+            // still playing, so however long the capture has gone quiet for, more is on its way
+            if (waitpid(*emitter, NULL, WNOHANG) == *emitter) {
+                *emitter = 0;
+                emitter_done_us = now_us();
+            }
+        } else if (emitter && now_us() - emitter_done_us >= (uint64_t)grace_ms * 1000) {
+            return; // everything it sent has had time to come through
+        }
+
+        int ret = poll(&pfd, 1, emitter ? 100 : -1);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            return;
+        }
+        if (ret == 0) continue;
+
+        uint8_t buf[64];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        uint64_t t = now_us();
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("read");
+            return;
+        }
+        if ((size_t)n != REPORT_SIZE) continue; // not one of ours
+        samples_push(out, t, buf);
+    }
+}
+
+static int uhid_write(int fd, const struct uhid_event *ev)
+{
+    ssize_t n = write(fd, ev, sizeof(*ev));
+    if (n != sizeof(*ev)) {
+        perror("uhid write");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Find the hidraw node the kernel made for our uhid device by looking for our unique string
+ */
+static int open_uhid_hidraw(const char *uniq)
+{
+    char want[128];
+    snprintf(want, sizeof(want), "HID_UNIQ=%s\n", uniq);
+
+    // the kernel takes a moment to probe the new device
+    for (int tries = 0; tries < 200; tries++) {
+        DIR *dir = opendir("/sys/class/hidraw");
+        if (dir) {
+            struct dirent *ent;
+            while ((ent = readdir(dir))) {
+                if (ent->d_name[0] == '.') continue;
+
+                char path[512];
+                snprintf(path, sizeof(path), "/sys/class/hidraw/%s/device/uevent", ent->d_name);
+                FILE *f = fopen(path, "r");
+                if (!f) continue;
+
+                char line[256];
+                bool match = false;
+                while (fgets(line, sizeof(line), f)) {
+                    if (strcmp(line, want) == 0) match = true;
+                }
+                fclose(f);
+
+                if (match) {
+                    snprintf(path, sizeof(path), "/dev/%s", ent->d_name);
+                    closedir(dir);
+                    return open(path, O_RDONLY | O_CLOEXEC);
+                }
+            }
+            closedir(dir);
+        }
+        usleep(10 * 1000);
+    }
+
+    errno = ENODEV;
+    return -1;
+}
+
+/**
+ * Play the capture into the uhid device on its own timeline, shifted to start at t0_us
+ */
+static void emit_capture(int uhid, const sample_list *capture, uint64_t t0_us)
+{
+    uint64_t first = capture->data[0].t_us;
+
+    for (size_t i = 0; i < capture->len; i++) {
+        uint64_t due = t0_us + (capture->data[i].t_us - first);
+        struct timespec ts = { .tv_sec = due / 1000000, .tv_nsec = (due % 1000000) * 1000 };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+
+        struct uhid_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.type = UHID_INPUT2;
+        ev.u.input2.size = REPORT_SIZE;
+        memcpy(ev.u.input2.data, capture->data[i].report, REPORT_SIZE);
+        if (uhid_write(uhid, &ev)) return;
+    }
+}
+
+static void print_intervals(const sample_list *rx)
+{
+    if (rx->len < 2) {
+        printf("reports:            %zu (need at least 2 for interval stats)\n", rx->len);
+        return;
+    }
+
+    uint64_t min = UINT64_MAX, max = 0;
+    double sum = 0, sum_sq = 0;
+    size_t dups = 0;
+    for (size_t i = 1; i < rx->len; i++) {
+        uint64_t dt = rx->data[i].t_us - rx->data[i - 1].t_us;
+        if (dt < min) min = dt;
+        if (dt > max) max = dt;
+        sum += dt;
+        sum_sq += (double)dt * dt;
+        if (memcmp(rx->data[i].report, rx->data[i - 1].report, REPORT_SIZE) == 0) dups++;
+    }
+    size_t n = rx->len - 1;
+    double mean = sum / n;
+    double var = sum_sq / n - mean * mean;
+
+    printf("reports:            %zu over %.3f s\n", rx->len, (rx->data[rx->len - 1].t_us - rx->data[0].t_us) / 1e6);
+    printf("interval:           mean %.1f us, min %llu us, max %llu us\n", mean, (unsigned long long)min, (unsigned long long)max);
+    printf("jitter:             stddev %.1f us, peak-to-peak %llu us\n", var > 0 ? sqrt(var) : 0.0, (unsigned long long)(max - min));
+    printf("duplicate reports:  %zu (%.1f%%)\n", dups, 100.0 * dups / n);
+}
+
+/**
+ * Compare what arrived against what was sent
+ * A transition counts as delivered if some report between it and the next transition on the same input shows it;
+ * latency is measured for presses only, from when the report was sent to when the first report showing it arrived
+ */
+static void print_transitions(const sample_list *rx, const sample_list *ref, uint64_t t0_us)
+{
+    uint64_t first = ref->data[0].t_us;
+    size_t total_missed = 0, total_transitions = 0;
+
+    printf("\n%-6s %8s %8s %12s %12s\n", "input", "presses", "missed", "mean lat us", "max lat us");
+
+    for (int bit = 0; bit < NUM_INPUTS; bit++) {
+        size_t presses = 0, missed = 0, measured = 0;
+        uint64_t lat_sum = 0, lat_max = 0;
+        size_t j = 0;
+        bool prev = false;
+
+        for (size_t i = 0; i < ref->len; i++) {
+            bool value = report_state(ref->data[i].report) & (1 << bit);
+            if (value == prev) continue;
+            prev = value;
+
+            uint64_t t = t0_us + (ref->data[i].t_us - first);
+            uint64_t t_next = UINT64_MAX;
+            for (size_t k = i + 1; k < ref->len; k++) {
+                if ((bool)(report_state(ref->data[k].report) & (1 << bit)) != value) {
+                    t_next = t0_us + (ref->data[k].t_us - first);
+                    break;
+                }
+            }
+
+            // rx is in time order, so carry on from wherever the last transition left off
+            while (j < rx->len && rx->data[j].t_us < t) j++;
+            size_t k = j;
+            while (k < rx->len && rx->data[k].t_us < t_next && (bool)(report_state(rx->data[k].report) & (1 << bit)) != value) k++;
+
+            total_transitions++;
+            if (value) presses++;
+            if (k == rx->len || rx->data[k].t_us >= t_next) {
+                missed++;
+                continue;
+            }
+            if (value) {
+                uint64_t lat = rx->data[k].t_us - t;
+                lat_sum += lat;
+                if (lat > lat_max) lat_max = lat;
+                measured++;
+            }
+        }
+
+        total_missed += missed;
+        if (presses == 0 && missed == 0) continue;
+        printf("%-6s %8zu %8zu %12.1f %12llu\n", input_names[bit], presses, missed,
+            measured ? (double)lat_sum / measured : 0.0, (unsigned long long)lat_max);
+    }
+
+    printf("\nmissed transitions: %zu of %zu\n", total_missed, total_transitions);
+}
+
+static int run_live(const char *dev, size_t count)
+{
+    int fd = open(dev, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(dev);
+        return 1;
+    }
+
+    sample_list rx = {0};
+    fprintf(stderr, "reading %s, ctrl-c to stop\n", dev);
+    read_hidraw(fd, count, NULL, 0, &rx);
+    close(fd);
+
+    print_intervals(&rx);
+    free(rx.data);
+    return 0;
+}
+
+static int run_replay(const char *path, int player)
+{
+    sample_list capture = {0};
+    if (!load_capture(path, player, &capture)) return 1;
+    if (capture.len == 0) {
+        fprintf(stderr, "%s: no reports for player %d\n", path, player);
+        return 1;
+    }
+
+    int uhid = open("/dev/uhid", O_RDWR | O_CLOEXEC);
+    if (uhid < 0) {
+        perror("/dev/uhid");
+        return 1;
+    }
+
+    char uniq[64];
+    snprintf(uniq, sizeof(uniq), "hidlat-%d", (int)getpid());
+
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_CREATE2;
+    snprintf((char *)ev.u.create2.name, sizeof(ev.u.create2.name), "arcade stick replay");
+    snprintf((char *)ev.u.create2.uniq, sizeof(ev.u.create2.uniq), "%s", uniq);
+    ev.u.create2.rd_size = sizeof(desc_hid_report);
+    memcpy(ev.u.create2.rd_data, desc_hid_report, sizeof(desc_hid_report));
+    ev.u.create2.bus = 0x03; // BUS_USB
+    ev.u.create2.vendor = USB_VID;
+    ev.u.create2.product = USB_PID;
+    if (uhid_write(uhid, &ev)) {
+        close(uhid);
+        return 1;
+    }
+
+    int fd = open_uhid_hidraw(uniq);
+    if (fd < 0) {
+        perror("hidraw for uhid device");
+        close(uhid);
+        return 1;
+    }
+
+    // give ourselves a little lead so the emitter's first sleep is real
+    uint64_t t0 = now_us() + 50 * 1000;
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0) {
+        close(fd);
+        emit_capture(uhid, &capture, t0);
+        _exit(0);
+    }
+
+    sample_list rx = {0};
+    // the capture can sit idle for as long as it likes, so run until the emitter is done rather than until it's quiet
+    read_hidraw(fd, capture.len, &child, REPLAY_GRACE_MS, &rx);
+    if (child) {
+        // every report came back, or we were interrupted, before the emitter finished
+        if (stop) kill(child, SIGTERM);
+        waitpid(child, NULL, 0);
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_DESTROY;
+    uhid_write(uhid, &ev);
+    close(fd);
+    close(uhid);
+
+    printf("replayed:           %zu reports for player %d from %s\n", capture.len, player, path);
+    print_intervals(&rx);
+    if (rx.len) {
+        print_transitions(&rx, &capture, t0);
+    }
+
+    free(rx.data);
+    free(capture.data);
+    return 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [-n count] /dev/hidrawN\n"
+        "       %s -r capture.txt [-p player]\n"
+        "\n"
+        "  -n count    stop after this many reports (default: until ctrl-c)\n"
+        "  -r capture  replay a capture through a uhid device and analyse what comes back\n"
+        "  -p player   which player's reports to replay (default: 1)\n",
+        argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *replay = NULL;
+    size_t count = 0;
+    int player = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:p:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            replay = optarg;
+            break;
+        case 'p':
+            player = atoi(optarg);
+            if (player != 1 && player != 2) {
+                fprintf(stderr, "%s: player must be 1 or 2\n", argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (replay) {
+        return run_replay(replay, player);
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    return run_live(argv[optind], count);
+}
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "link.h"
+
+/**
+ * linkcheck - push inter-board link frames through a simulated UART and check what comes out the other end
+ *
+ * The pipe is just a byte buffer that the sender writes frames into, with hooks for the ways a real cable goes wrong:
+ * whole frames lost, single bytes lost, and bits flipped. The receiver is the same link_decoder the stick board runs.
+ */
+
+#define PAYLOAD_LEN 8   // what the psx board sends, two buttons reports
+#define PIPE_SIZE   (64 * 1024)
+
+typedef struct {
+    uint8_t bytes[PIPE_SIZE];
+    size_t len;
+} pipe_buf;
+
+typedef struct {
+    link_decoder dec;
+    uint32_t good;      // frames that came out matching what was sent
+    uint32_t bad;       // frames the decoder accepted that were never sent, which must never happen
+} receiver;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// payload for a given sequence number, packed with sync bytes so a decoder that's lost its place has plenty to trip on
+static void make_payload(uint8_t seq, uint8_t *payload)
+{
+    for (int i = 0; i < PAYLOAD_LEN; i++) {
+        payload[i] = (i & 1) ? LINK_SYNC : (uint8_t)(seq + i);
+    }
+}
+
+static size_t send_frame(pipe_buf *pipe, uint8_t seq)
+{
+    uint8_t payload[PAYLOAD_LEN];
+    make_payload(seq, payload);
+    size_t n = link_encode(seq, payload, PAYLOAD_LEN, pipe->bytes + pipe->len);
+    pipe->len += n;
+    return n;
+}
+
+static void receive(receiver *rx, const pipe_buf *pipe)
+{
+    for (size_t i = 0; i < pipe->len; i++) {
+        if (!link_decode_byte(&rx->dec, pipe->bytes[i])) continue;
+
+        uint8_t expected[PAYLOAD_LEN];
+        make_payload(rx->dec.seq, expected);
+        if (rx->dec.len == PAYLOAD_LEN && memcmp(rx->dec.payload, expected, PAYLOAD_LEN) == 0) {
+            rx->good++;
+        } else {
+            rx->bad++;
+        }
+    }
+}
+
+static void receiver_init(receiver *rx)
+{
+    link_decoder_init(&rx->dec);
+    rx->good = 0;
+    rx->bad = 0;
+}
+
+/**
+ * A clean run long enough for the sequence number to wrap
+ */
+static void check_clean_wrap(void)
+{
+    pipe_buf pipe = {0};
+    receiver rx;
+    receiver_init(&rx);
+
+    for (int i = 0; i < 600; i++) {
+        send_frame(&pipe, (uint8_t)(250 + i));
+    }
+    receive(&rx, &pipe);
+
+    CHECK(rx.good == 600);
+    CHECK(rx.bad == 0);
+    CHECK(rx.dec.frames == 600);
+    CHECK(rx.dec.crc_errors == 0);
+    CHECK(rx.dec.dropped == 0);
+}
+
+/**
+ * Whole frames never making it, including across the sequence wrap
+ */
+static void check_dropped_frames(void)
+{
+    pipe_buf pipe = {0};
+    receiver rx;
+    receiver_init(&rx);
+
+    uint32_t sent = 0;
+    for (int i = 0; i < 300; i++) {
+        uint8_t seq = (uint8_t)(200 + i);
+        size_t start = pipe.len;
+        send_frame(&pipe, seq);
+        sent++;
+        if (seq == 254 || seq == 255 || seq == 0 || i == 100) {
+            pipe.len = start; // lost on the wire
+            sent--;
+        }
+    }
+    receive(&rx, &pipe);
+
+    CHECK(rx.good == sent);
+    CHECK(rx.bad == 0);
+    CHECK(rx.dec.frames == sent);
+    CHECK(rx.dec.crc_errors == 0);
+    CHECK(rx.dec.dropped == 4);
+}
+
+/**
+ * A single flipped bit anywhere in a frame must cost that frame, and at most the next one if it hit the length
+ */
+static void check_bit_flips(void)
+{
+    for (size_t pos = 1; pos < PAYLOAD_LEN + LINK_OVERHEAD; pos++) {
+        for (int bit = 0; bit < 8; bit++) {
+            pipe_buf pipe = {0};
+            receiver rx;
+            receiver_init(&rx);
+
+            send_frame(&pipe, 10);
+            size_t start = pipe.len;
+            send_frame(&pipe, 11);
+            pipe.bytes[start + pos] ^= 1 << bit;
+            for (int i = 12; i < 20; i++) {
+                send_frame(&pipe, (uint8_t)i);
+            }
+            receive(&rx, &pipe);
+
+            // a flipped length byte can swallow the following frame's start as well, but no more than that
+            CHECK(rx.bad == 0);
+            CHECK(rx.good >= 8 && rx.good <= 9);
+            CHECK(rx.dec.frames == rx.good);
+            CHECK(rx.dec.dropped == 10 - rx.good);
+            if (pos != 2) {
+                // anything but the length keeps the frame boundaries intact, so it's exactly one crc error
+                CHECK(rx.dec.crc_errors == 1);
+                CHECK(rx.good == 9);
+            }
+        }
+    }
+}
+
+/**
+ * Losing the real sync byte leaves the decoder to find the 0xA5s inside the payload first, none of which can be
+ * allowed to turn into a frame
+ */
+static void check_false_sync(void)
+{
+    pipe_buf pipe = {0};
+    receiver rx;
+    receiver_init(&rx);
+
+    for (int i = 0; i < 50; i++) {
+        size_t start = pipe.len;
+        size_t n = send_frame(&pipe, (uint8_t)i);
+        if (i % 5 == 2) {
+            // drop one byte out of the frame, the sync byte on even frames, something in the middle on odd ones
+            size_t drop = start + ((i & 1) ? n / 2 : 0);
+            memmove(pipe.bytes + drop, pipe.bytes + drop + 1, pipe.len - drop - 1);
+            pipe.len--;
+        }
+    }
+    receive(&rx, &pipe);
+
+    CHECK(rx.bad == 0);
+    // every damaged frame is lost, and may take the one after it too while the decoder finds its feet
+    CHECK(rx.good >= 50 - 2 * 10);
+    CHECK(rx.good <= 50 - 10);
+    CHECK(rx.dec.frames == rx.good);
+    CHECK(rx.dec.dropped == 50 - rx.good);
+}
+
+/**
+ * Oversized frames are refused by the encoder, and a bogus length on the wire doesn't wedge the decoder
+ */
+static void check_lengths(void)
+{
+    uint8_t big[LINK_MAX_PAYLOAD + 1] = {0};
+    uint8_t frame[LINK_MAX_FRAME + 1];
+    CHECK(link_encode(0, big, sizeof(big), frame) == 0);
+    CHECK(link_encode(0, big, LINK_MAX_PAYLOAD, frame) == LINK_MAX_FRAME);
+
+    pipe_buf pipe = {0};
+    receiver rx;
+    receiver_init(&rx);
+
+    uint8_t junk[] = { LINK_SYNC, 0x00, LINK_MAX_PAYLOAD + 1, 0x12, 0x34 };
+    memcpy(pipe.bytes, junk, sizeof(junk));
+    pipe.len = sizeof(junk);
+    send_frame(&pipe, 1);
+    receive(&rx, &pipe);
+
+    CHECK(rx.good == 1);
+    CHECK(rx.bad == 0);
+}
+
+int main(void)
+{
+    check_clean_wrap();
+    check_dropped_frames();
+    check_bit_flips();
+    check_false_sync();
+    check_lengths();
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all link checks passed\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "turbo.h"
+
+/**
+ * turbocheck - hold the stick board's turbo engine to a simple per-button model
+ *
+ * The reference gives every turbo button its own phase, the way a timer per button would: pressed for a half period
+ * of frames, released for the next. The engine's grouped masks have to agree with it on every frame, including across
+ * the 11 bit SOF counter wrapping, which the engine only sees through turbo_frame_update() just like the firmware.
+ */
+
+#define NUM_BUTTONS 12
+#define SOF_WRAP    (TURBO_SOF_MASK + 1)
+
+static const uint32_t half_period[TURBO_NUM_RATES] = { 17, 25, 33, 50 };
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+/**
+ * What the release mask should be, one button at a time
+ */
+static uint16_t reference_mask(const turbo_rate *rates, uint32_t frame)
+{
+    uint16_t mask = 0;
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+        if (rates[b] == TURBO_OFF) continue;
+        if ((frame / half_period[rates[b]]) & 1) mask |= 1 << b;
+    }
+    return mask;
+}
+
+/**
+ * The running count follows the real frame number through several SOF wraps, however it's sampled
+ * stick.c reads it once or more per frame while streaming turbo reports, but a held up main loop can skip one
+ */
+static void check_frame_counter(void)
+{
+    turbo_frame_counter counter = {0};
+    uint32_t frame = 0;
+    uint32_t mismatches = 0;
+
+    srand(1);
+    while (frame < 5 * SOF_WRAP) {
+        uint32_t got = turbo_frame_update(&counter, frame & TURBO_SOF_MASK);
+        if (got != frame) mismatches++;
+        frame += rand() % 3; // same frame again, the next one, or one missed
+    }
+    CHECK(mismatches == 0);
+
+    // and right on the wrap, starting from an arbitrary point like a real SOF counter would
+    turbo_frame_counter late = { .last_sof = SOF_WRAP - 3, .frame = 1000 };
+    CHECK(turbo_frame_update(&late, SOF_WRAP - 1) == 1002);
+    CHECK(turbo_frame_update(&late, 0) == 1003);
+    CHECK(turbo_frame_update(&late, 1) == 1004);
+}
+
+/**
+ * Every rate, and a mix of rates, matches the reference on every frame across the wrap
+ */
+static void check_against_reference(void)
+{
+    turbo_rate rates[NUM_BUTTONS];
+    turbo_config turbo;
+
+    srand(2);
+    for (int run = 0; run < 50; run++) {
+        turbo_init(&turbo);
+        for (int b = 0; b < NUM_BUTTONS; b++) {
+            // the first few runs put all twelve on one rate, the rest are random
+            rates[b] = run < TURBO_NUM_RATES ? (turbo_rate)run : (turbo_rate)(rand() % (TURBO_NUM_RATES + 1));
+            turbo_set(&turbo, 1 << b, rates[b]);
+        }
+
+        turbo_frame_counter counter = { .last_sof = SOF_WRAP - 200, .frame = SOF_WRAP - 200 };
+        uint32_t mismatches = 0;
+        for (uint32_t frame = SOF_WRAP - 200; frame < 3 * SOF_WRAP; frame++) {
+            uint32_t f = turbo_frame_update(&counter, frame & TURBO_SOF_MASK);
+            if (turbo_release_mask(&turbo, f) != reference_mask(rates, frame)) mismatches++;
+        }
+        CHECK(mismatches == 0);
+    }
+
+    // moving a button to another rate takes it off the old one
+    turbo_init(&turbo);
+    turbo_set(&turbo, 0x0FFF, TURBO_10HZ);
+    turbo_set(&turbo, 1 << 3, TURBO_30HZ);
+    CHECK(turbo.rate_mask[TURBO_10HZ] == (0x0FFF & ~(1 << 3)));
+    CHECK(turbo.rate_mask[TURBO_30HZ] == (1 << 3));
+    CHECK(turbo_buttons(&turbo) == 0x0FFF);
+    turbo_set(&turbo, 0x0FFF, TURBO_OFF);
+    for (int r = 0; r < TURBO_NUM_RATES; r++) {
+        CHECK(turbo.rate_mask[r] == 0);
+    }
+    CHECK(turbo_buttons(&turbo) == 0);
+}
+
+/**
+ * A turbo phase never flips mid half period at the wrap, so each button's press and release stay the full length
+ */
+static void check_phase_at_wrap(void)
+{
+    for (int r = 0; r < TURBO_NUM_RATES; r++) {
+        turbo_config turbo;
+        turbo_init(&turbo);
+        turbo_set(&turbo, 1, (turbo_rate)r);
+
+        turbo_frame_counter counter = { .last_sof = SOF_WRAP - 500, .frame = SOF_WRAP - 500 };
+        uint16_t last = turbo_release_mask(&turbo, counter.frame);
+        uint32_t run = 0, short_runs = 0, runs = 0;
+        bool first = true;
+        for (uint32_t frame = SOF_WRAP - 499; frame < SOF_WRAP + 500; frame++) {
+            uint16_t mask = turbo_release_mask(&turbo, turbo_frame_update(&counter, frame & TURBO_SOF_MASK));
+            run++;
+            if (mask != last) {
+                // the very first run started part way through, so only judge the ones after it
+                if (!first && run != half_period[r]) short_runs++;
+                first = false;
+                runs++;
+                run = 0;
+                last = mask;
+            }
+        }
+        CHECK(runs > 2);
+        CHECK(short_runs == 0);
+    }
+}
+
+/**
+ * Only buttons that have turbo on are ever released, and every one of them is at some point in a full cycle
+ */
+static void check_only_configured(void)
+{
+    srand(3);
+    for (int run = 0; run < 50; run++) {
+        turbo_config turbo;
+        turbo_init(&turbo);
+        for (int b = 0; b < NUM_BUTTONS; b++) {
+            turbo_set(&turbo, 1 << b, (turbo_rate)(rand() % (TURBO_NUM_RATES + 1)));
+        }
+
+        uint16_t configured = turbo_buttons(&turbo);
+        uint16_t seen = 0;
+        for (uint32_t frame = 0; frame < 2 * half_period[TURBO_10HZ]; frame++) {
+            seen |= turbo_release_mask(&turbo, frame);
+        }
+        CHECK((seen & ~configured) == 0);
+        CHECK(seen == configured);
+    }
+}
+
+int main(void)
+{
+    check_frame_counter();
+    check_against_reference();
+    check_phase_at_wrap();
+    check_only_configured();
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all turbo checks passed\n");
+    return 0;
+}
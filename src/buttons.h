@@ -0,0 +1,33 @@
+#ifndef _BUTTONS_H_
+#define _BUTTONS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ATTRIBUTE_PACKED  __attribute__((packed, aligned(1)))
+
+/**
+ * Struct to hold our HID report data
+ * This needs to be tightly packed and optimised in order to pass the correct bit fields defined in usb_descriptors.c
+ */
+typedef struct ATTRIBUTE_PACKED {
+    uint8_t x;
+    uint8_t y;
+    bool a:1;
+    bool b:1;
+    bool c:1;
+    bool d:1;
+    bool e:1;
+    bool f:1;
+    bool g:1;
+    bool h:1;
+    bool i:1;
+    bool j:1;
+    bool k:1;
+    bool l:1;
+} buttons;
+
+// a centred stick with nothing pressed
+#define BUTTONS_IDLE { .x = 128, .y = 128 }
+
+#endif /* _BUTTONS_H_ */
@@ -0,0 +1,191 @@
+#include "csync.h"
+
+// instruction addresses in the csync program
+enum {
+    CSYNC_PC_ENTRY = 0,     // jmp pin vsync
+    CSYNC_PC_FOLLOW,        // mov pins, pins
+    CSYNC_PC_VSYNC,         // mov osr, pins
+    CSYNC_PC_VSYNC_OUT,     // out x, 1
+    CSYNC_PC_VSYNC_TEST,    // jmp x-- vsync_line
+    CSYNC_PC_VSYNC_LOW,     // set pins, 0
+    CSYNC_PC_VSYNC_EDGE,    // wait 1 pin 0
+    CSYNC_PC_LINE,          // set pins, 1
+    CSYNC_PC_SAVE,          // mov x, y
+    CSYNC_PC_PULL,          // pull noblock
+    CSYNC_PC_LOAD,          // mov y, osr
+    CSYNC_PC_COUNT,         // mov x, y
+    CSYNC_PC_BROAD,         // jmp x-- broad
+    CSYNC_PC_SERRATE,       // set pins, 0
+    CSYNC_PC_WAIT,          // wait 1 pin 0
+    CSYNC_PC_NEXT,          // jmp pin vsync_line
+    CSYNC_PC_DONE           // jmp entry
+};
+
+/**
+ * A sync pulse is always the short part of the period, so if the "active" part is the longer one we've got the
+ * polarity backwards
+ */
+bool csync_inverted(uint32_t active, uint32_t idle)
+{
+    return active > idle;
+}
+
+/**
+ * How many loops of the csync program's broad pulse make it end one hsync width before the next line starts
+ * active and idle are in sync_measure counts
+ */
+uint32_t csync_broad_cycles(uint32_t active, uint32_t idle)
+{
+    (void) active;
+    uint32_t cycles = idle * CSYNC_MEASURE_CYCLES;
+
+    if (cycles <= CSYNC_BROAD_OVERHEAD + CSYNC_BROAD_MARGIN) {
+        return 0;
+    }
+    return cycles - CSYNC_BROAD_OVERHEAD - CSYNC_BROAD_MARGIN;
+}
+
+void csync_filter_reset(csync_filter *f)
+{
+    f->last_active = 0;
+    f->last_idle = 0;
+    f->inverted_run = 0;
+    f->stable_run = 0;
+}
+
+static bool csync_agrees(uint32_t a, uint32_t b)
+{
+    return a + CSYNC_WOBBLE >= b && b + CSYNC_WOBBLE >= a;
+}
+
+/**
+ * Take one measurement from sync_measure and say what, if anything, the cpu should do about it
+ * Only CSYNC_AGREE measurements in a row saying the same thing count, so a junk measurement after a missing sync, or
+ * a stale one from before a flip, can't flip the polarity or change the broad pulses by itself
+ */
+csync_action csync_filter_push(csync_filter *f, uint32_t active, uint32_t idle)
+{
+    if (csync_inverted(active, idle)) {
+        f->stable_run = 0;
+        if (++f->inverted_run < CSYNC_AGREE) return CSYNC_KEEP;
+        csync_filter_reset(f);
+        return CSYNC_FLIP;
+    }
+    f->inverted_run = 0;
+
+    if (f->stable_run && csync_agrees(active, f->last_active) && csync_agrees(idle, f->last_idle)) {
+        if (f->stable_run < CSYNC_AGREE) f->stable_run++;
+    } else {
+        f->stable_run = 1;
+    }
+    f->last_active = active;
+    f->last_idle = idle;
+    return f->stable_run >= CSYNC_AGREE ? CSYNC_LINE : CSYNC_KEEP;
+}
+
+void csync_sim_init(csync_sim *sim)
+{
+    sim->pc = CSYNC_PC_ENTRY;
+    sim->x = 0;
+    sim->y = 0;
+    sim->osr = 0;
+    sim->fifo_full = false;
+    sim->fifo = 0;
+    sim->hsync_sync = 0;
+    sim->vsync_sync = 0;
+    sim->csync = false;
+}
+
+void csync_sim_put(csync_sim *sim, uint32_t broad)
+{
+    sim->fifo = broad;
+    sim->fifo_full = true;
+}
+
+/**
+ * Run the csync program for one system clock cycle with the given (already active high) input levels
+ * Returns the csync output level at the end of the cycle, active high
+ */
+bool csync_sim_step(csync_sim *sim, bool hsync, bool vsync)
+{
+    // inputs reach the state machine through two flops
+    bool h = (sim->hsync_sync >> 1) & 1;
+    bool v = (sim->vsync_sync >> 1) & 1;
+    sim->hsync_sync = ((sim->hsync_sync << 1) | hsync) & 3;
+    sim->vsync_sync = ((sim->vsync_sync << 1) | vsync) & 3;
+
+    switch (sim->pc) {
+    case CSYNC_PC_ENTRY:
+        sim->pc = v ? CSYNC_PC_VSYNC : CSYNC_PC_FOLLOW;
+        break;
+    case CSYNC_PC_FOLLOW:
+        sim->csync = h;
+        sim->pc = CSYNC_PC_ENTRY; // wrap
+        break;
+    case CSYNC_PC_VSYNC:
+        sim->osr = h;
+        sim->pc = CSYNC_PC_VSYNC_OUT;
+        break;
+    case CSYNC_PC_VSYNC_OUT:
+        sim->x = sim->osr & 1;
+        sim->osr >>= 1;
+        sim->pc = CSYNC_PC_VSYNC_TEST;
+        break;
+    case CSYNC_PC_VSYNC_TEST:
+        sim->pc = sim->x ? CSYNC_PC_LINE : CSYNC_PC_VSYNC_LOW;
+        sim->x--;
+        break;
+    case CSYNC_PC_VSYNC_LOW:
+        sim->csync = false;
+        sim->pc = CSYNC_PC_VSYNC_EDGE;
+        break;
+    case CSYNC_PC_VSYNC_EDGE:
+        if (h) sim->pc = CSYNC_PC_LINE; // otherwise stall
+        break;
+    case CSYNC_PC_LINE:
+        sim->csync = true;
+        sim->pc = CSYNC_PC_SAVE;
+        break;
+    case CSYNC_PC_SAVE:
+        sim->x = sim->y;
+        sim->pc = CSYNC_PC_PULL;
+        break;
+    case CSYNC_PC_PULL:
+        if (sim->fifo_full) {
+            sim->osr = sim->fifo;
+            sim->fifo_full = false;
+        } else {
+            sim->osr = sim->x;
+        }
+        sim->pc = CSYNC_PC_LOAD;
+        break;
+    case CSYNC_PC_LOAD:
+        sim->y = sim->osr;
+        sim->pc = CSYNC_PC_COUNT;
+        break;
+    case CSYNC_PC_COUNT:
+        sim->x = sim->y;
+        sim->pc = CSYNC_PC_BROAD;
+        break;
+    case CSYNC_PC_BROAD:
+        sim->pc = sim->x ? CSYNC_PC_BROAD : CSYNC_PC_SERRATE;
+        sim->x--;
+        break;
+    case CSYNC_PC_SERRATE:
+        sim->csync = false;
+        sim->pc = CSYNC_PC_WAIT;
+        break;
+    case CSYNC_PC_WAIT:
+        if (h) sim->pc = CSYNC_PC_NEXT; // otherwise stall
+        break;
+    case CSYNC_PC_NEXT:
+        sim->pc = v ? CSYNC_PC_LINE : CSYNC_PC_DONE;
+        break;
+    case CSYNC_PC_DONE:
+    default:
+        sim->pc = CSYNC_PC_ENTRY;
+        break;
+    }
+
+    return sim->csync;
+}
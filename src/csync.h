@@ -0,0 +1,66 @@
+#ifndef _CSYNC_H_
+#define _CSYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Composite sync regeneration timing model
+ *
+ * The vga board's PIO measures hsync and vsync with sync_measure and rebuilds a clean csync with the csync program
+ * (see csync.pio). The cpu only ever has to decide polarity and how long the broad pulses in vsync should be, and
+ * those decisions live here along with a cycle level model of the csync program, so the host can run recorded sync
+ * waveforms through exactly the same logic (host/csyncsim.c, and host/csynccheck.c for the measurement filter).
+ */
+
+#define CSYNC_SYS_CLK_HZ        125000000
+#define CSYNC_MEASURE_CYCLES    2   // cycles per count from sync_measure
+#define CSYNC_BROAD_OVERHEAD    6   // cycles of the csync program's broad pulse that aren't the counted loop
+#define CSYNC_BROAD_MARGIN      8   // finish a little early so we're always waiting when the next hsync arrives
+// gap between hsync pulses on a 15.7kHz line (~58.8us) in sync_measure counts, for broad pulses before the first
+// measurement comes in
+#define CSYNC_DEFAULT_IDLE      3675
+
+// measurements in a row that have to agree before the cpu flips a polarity or changes the line length. sync_measure's
+// counts are only 16 bits, so with a sync missing (source off, mode change) whatever finally comes out is junk
+#define CSYNC_AGREE             3
+#define CSYNC_WOBBLE            2   // counts either way that still agree, measurements wobble by about one
+
+typedef enum {
+    CSYNC_KEEP = 0,     // nothing to do yet
+    CSYNC_FLIP,         // the input's polarity is backwards
+    CSYNC_LINE          // a settled line length, in the measurement just pushed
+} csync_action;
+
+typedef struct {
+    uint32_t last_active;
+    uint32_t last_idle;
+    uint8_t inverted_run;
+    uint8_t stable_run;
+} csync_filter;
+
+bool csync_inverted(uint32_t active, uint32_t idle);
+uint32_t csync_broad_cycles(uint32_t active, uint32_t idle);
+void csync_filter_reset(csync_filter *f);
+csync_action csync_filter_push(csync_filter *f, uint32_t active, uint32_t idle);
+
+/**
+ * State of one csync state machine, cycle by cycle
+ */
+typedef struct {
+    uint8_t pc;
+    uint32_t x;
+    uint32_t y;
+    uint32_t osr;
+    bool fifo_full;         // a one deep stand-in for the TX FIFO
+    uint32_t fifo;
+    uint8_t hsync_sync;     // the two flop input synchronisers, newest sample in bit 0
+    uint8_t vsync_sync;
+    bool csync;             // active high, like the program sees it
+} csync_sim;
+
+void csync_sim_init(csync_sim *sim);
+void csync_sim_put(csync_sim *sim, uint32_t broad);
+bool csync_sim_step(csync_sim *sim, bool hsync, bool vsync);
+
+#endif /* _CSYNC_H_ */
@@ -0,0 +1,43 @@
+#include "guncon.h"
+
+// guncon button bits, as they sit in the (inverted) 16 bit buttons word
+#define GUNCON_BTN_A        (1 << 3)
+#define GUNCON_BTN_TRIGGER  (1 << 13)
+#define GUNCON_BTN_B        (1 << 14)
+
+/**
+ * Map a raw gun coordinate onto 0-255, clamping anything outside the calibrated range to the edge
+ */
+static uint8_t guncon_scale(uint16_t value, uint16_t min, uint16_t max)
+{
+    if (value <= min) return 0;
+    if (value >= max) return 255;
+    return (uint8_t)(((uint32_t)(value - min) * 255) / (max - min));
+}
+
+/**
+ * Turn one poll response into the gun's report
+ * Returns false, and leaves the gun idle, if whatever answered isn't a Guncon (or nothing did)
+ */
+bool guncon_decode(const uint8_t *resp, size_t len, buttons *gun)
+{
+    if (len < GUNCON_POLL_LEN || resp[1] != GUNCON_ID || resp[2] != 0x5A) {
+        const buttons idle = BUTTONS_IDLE;
+        *gun = idle;
+        return false;
+    }
+
+    uint16_t held = ~(resp[3] | (resp[4] << 8));
+    uint16_t x = resp[5] | (resp[6] << 8);
+    uint16_t y = resp[7] | (resp[8] << 8);
+
+    gun->a = (held & GUNCON_BTN_TRIGGER) != 0;
+    gun->b = (held & GUNCON_BTN_A) != 0;
+    gun->c = (held & GUNCON_BTN_B) != 0;
+    gun->d = (x == 1 && (y == 5 || y == 10));
+    if (!gun->d) {
+        gun->x = guncon_scale(x, GUNCON_X_MIN, GUNCON_X_MAX);
+        gun->y = guncon_scale(y, GUNCON_Y_MIN, GUNCON_Y_MAX);
+    }
+    return true;
+}
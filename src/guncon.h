@@ -0,0 +1,42 @@
+#ifndef _GUNCON_H_
+#define _GUNCON_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "buttons.h"
+
+/**
+ * Namco Guncon (NPC-103) poll decoding
+ *
+ * The psx board polls each port with the standard controller read, 0x01 0x42 followed by zeroes, and gets back:
+ *
+ *   [0xFF] [0x63] [0x5A] [buttons lo] [buttons hi] [x lo] [x hi] [y lo] [y hi]
+ *
+ * Buttons are active low, with the trigger where a pad has circle, A on start and B on cross. X counts 8MHz clocks
+ * from hsync and Y counts scanlines from vsync, both latched by the gun when it sees the beam, so they only change
+ * once per video field. X=1 with Y=5 or Y=10 means the gun didn't see a usable picture, i.e. it's pointed offscreen.
+ *
+ * Positions get scaled onto the same 0-255 axes as the sticks, and the buttons go out as:
+ *
+ *   a  trigger
+ *   b  A (side button)
+ *   c  B (side button)
+ *   d  offscreen, held while the gun can't see the screen, with x and y left where they last were
+ *
+ * host/guncheck.c feeds this canned responses and carries the result across the inter-board link.
+ */
+
+#define GUNCON_ID           0x63
+#define GUNCON_POLL_LEN     9
+
+// where the picture usually sits on a 240 line 15kHz source; a different source can need these nudging
+#define GUNCON_X_MIN        77
+#define GUNCON_X_MAX        461
+#define GUNCON_Y_MIN        25
+#define GUNCON_Y_MAX        265
+
+bool guncon_decode(const uint8_t *resp, size_t len, buttons *gun);
+
+#endif /* _GUNCON_H_ */
@@ -0,0 +1,114 @@
+#include "link.h"
+
+/**
+ * CRC-8 (poly 0x07) over a single byte
+ * Bitwise rather than a table, since frames are tiny and flash/ram is better spent elsewhere
+ */
+uint8_t link_crc8(uint8_t crc, uint8_t byte)
+{
+    crc ^= byte;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * Build a frame for the given payload into out, which must hold at least LINK_MAX_FRAME bytes
+ * Returns the number of bytes to send, or 0 if the payload is too big
+ */
+size_t link_encode(uint8_t seq, const uint8_t *payload, uint8_t len, uint8_t *out)
+{
+    if (len > LINK_MAX_PAYLOAD) {
+        return 0;
+    }
+
+    uint8_t crc = 0;
+    size_t n = 0;
+
+    out[n++] = LINK_SYNC;
+    out[n++] = seq;
+    crc = link_crc8(crc, seq);
+    out[n++] = len;
+    crc = link_crc8(crc, len);
+    for (uint8_t i = 0; i < len; i++) {
+        out[n++] = payload[i];
+        crc = link_crc8(crc, payload[i]);
+    }
+    out[n++] = crc;
+
+    return n;
+}
+
+void link_decoder_init(link_decoder *dec)
+{
+    dec->state = LINK_WAIT_SYNC;
+    dec->seq = 0;
+    dec->len = 0;
+    dec->pos = 0;
+    dec->crc = 0;
+    dec->frames = 0;
+    dec->crc_errors = 0;
+    dec->dropped = 0;
+    dec->last_seq = 0;
+}
+
+/**
+ * Feed one received byte into the decoder
+ * Returns true when a complete, valid frame is sitting in dec->payload (dec->len bytes long)
+ */
+bool link_decode_byte(link_decoder *dec, uint8_t byte)
+{
+    switch (dec->state) {
+    case LINK_WAIT_SYNC:
+        if (byte == LINK_SYNC) {
+            dec->state = LINK_WAIT_SEQ;
+            dec->crc = 0;
+        }
+        return false;
+
+    case LINK_WAIT_SEQ:
+        dec->seq = byte;
+        dec->crc = link_crc8(dec->crc, byte);
+        dec->state = LINK_WAIT_LEN;
+        return false;
+
+    case LINK_WAIT_LEN:
+        if (byte > LINK_MAX_PAYLOAD) {
+            // can't be a real frame, so go hunting for the next sync
+            dec->state = LINK_WAIT_SYNC;
+            return false;
+        }
+        dec->len = byte;
+        dec->pos = 0;
+        dec->crc = link_crc8(dec->crc, byte);
+        dec->state = byte ? LINK_WAIT_PAYLOAD : LINK_WAIT_CRC;
+        return false;
+
+    case LINK_WAIT_PAYLOAD:
+        dec->payload[dec->pos++] = byte;
+        dec->crc = link_crc8(dec->crc, byte);
+        if (dec->pos == dec->len) {
+            dec->state = LINK_WAIT_CRC;
+        }
+        return false;
+
+    case LINK_WAIT_CRC:
+        dec->state = LINK_WAIT_SYNC;
+        if (byte != dec->crc) {
+            dec->crc_errors++;
+            return false;
+        }
+
+        // count any frames we missed between this one and the last good one
+        if (dec->frames > 0) {
+            dec->dropped += (uint8_t)(dec->seq - dec->last_seq - 1);
+        }
+        dec->last_seq = dec->seq;
+        dec->frames++;
+        return true;
+    }
+
+    dec->state = LINK_WAIT_SYNC;
+    return false;
+}
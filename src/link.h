@@ -0,0 +1,59 @@
+#ifndef _LINK_H_
+#define _LINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Inter-board link protocol
+ *
+ * The psx board streams its state to the stick board over a plain UART so the stick board can present
+ * everything as a single USB device. Each frame looks like:
+ *
+ *   [LINK_SYNC] [seq] [len] [payload ... len bytes] [crc8]
+ *
+ * The CRC covers seq, len and the payload. The decoder resyncs on the next LINK_SYNC byte whenever a
+ * frame is malformed, so a dropped or corrupted byte costs the frame it was in, and the one after as well if it
+ * was a length byte.
+ *
+ * host/linkcheck.c runs this against a simulated pipe with lost frames, lost bytes and flipped bits.
+ */
+
+#define LINK_SYNC           0xA5
+#define LINK_MAX_PAYLOAD    16
+#define LINK_OVERHEAD       4
+#define LINK_MAX_FRAME      (LINK_MAX_PAYLOAD + LINK_OVERHEAD)
+
+// 1Mbaud keeps a full psx frame (12 bytes, 10 bits each) to 120us on the wire, well under one 1ms USB frame
+#define LINK_BAUD           (1000 * 1000)
+
+typedef enum {
+    LINK_WAIT_SYNC = 0,
+    LINK_WAIT_SEQ,
+    LINK_WAIT_LEN,
+    LINK_WAIT_PAYLOAD,
+    LINK_WAIT_CRC
+} link_rx_state;
+
+typedef struct {
+    link_rx_state state;
+    uint8_t seq;
+    uint8_t len;
+    uint8_t pos;
+    uint8_t crc;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+
+    // counters for spotting a flaky cable
+    uint32_t frames;
+    uint32_t crc_errors;
+    uint32_t dropped;
+    uint8_t last_seq;
+} link_decoder;
+
+uint8_t link_crc8(uint8_t crc, uint8_t byte);
+size_t link_encode(uint8_t seq, const uint8_t *payload, uint8_t len, uint8_t *out);
+void link_decoder_init(link_decoder *dec);
+bool link_decode_byte(link_decoder *dec, uint8_t byte);
+
+#endif /* _LINK_H_ */
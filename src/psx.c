@@ -0,0 +1,217 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+
+#include "buttons.h"
+#include "guncon.h"
+#include "link.h"
+
+/**
+ * The two controller ports, straight off the schematic
+ * DAT and ACK are open collector from the gun, so they lean on the pull-ups; the rest we drive
+ */
+typedef struct {
+    uint dat;
+    uint cmd;
+    uint att;
+    uint clk;
+    uint ack;
+} psx_port;
+
+static const psx_port psx_ports[2] = {
+    { .dat = 0,  .cmd = 1,  .att = 2,  .clk = 3,  .ack = 4 },
+    { .dat = 21, .cmd = 22, .att = 26, .clk = 27, .ack = 28 }
+};
+
+// ~250kHz, the same clock a console reads its pads at
+#define PSX_HALF_BIT_US     2
+// a controller acks every byte but the last within a few tens of us, no ack means nothing's there (or it's done)
+#define PSX_ACK_TIMEOUT_US  100
+// how often each gun gets read; the gun only latches a new position once per video field anyway
+#define PSX_POLL_US         2000
+
+// inter-board link to the stick board, which does the usb side of things for us
+// GP8/GP9 come out on J2 pins 4/5 (GP4 is PS_ACK_1, so it can't be used)
+#define LINK_UART       uart1
+#define LINK_TX_PIN     8
+#define LINK_RX_PIN     9
+// state goes out as soon as it changes, and again at least this often so the stick board knows we're still here
+// (its link timeout is 100ms)
+#define LINK_HEARTBEAT_US (10 * 1000)
+
+/**
+ * State of each of the two lightgun ports
+ * Reported in the same layout as the stick's players so the stick board can pass it straight through
+ */
+buttons gun1 = BUTTONS_IDLE;
+buttons gun2 = BUTTONS_IDLE;
+
+static int link_dma_chan;
+static uint8_t link_frame[LINK_MAX_FRAME];
+
+void link_init(void);
+void link_task(void);
+void psx_init(void);
+void psx_task(void);
+size_t psx_poll(const psx_port *port, uint8_t *resp);
+
+int main() {
+    psx_init();
+    link_init();
+
+    while (1) {
+        psx_task();
+        link_task();
+        tight_loop_contents();
+    }
+}
+
+/**
+ * Set up the UART to the stick board
+ * Frames are handed to DMA so building the next one doesn't wait on the wire
+ */
+void link_init(void)
+{
+    uart_init(LINK_UART, LINK_BAUD);
+    gpio_set_function(LINK_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(LINK_RX_PIN, GPIO_FUNC_UART);
+    uart_set_fifo_enabled(LINK_UART, true);
+
+    link_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(link_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(LINK_UART, true));
+
+    dma_channel_configure(link_dma_chan, &c,
+        &uart_get_hw(LINK_UART)->dr,
+        link_frame,
+        0,
+        false
+    );
+}
+
+/**
+ * Send the current state of both ports to the stick board whenever it changes, or when the heartbeat is due
+ *
+ * A change is picked up on the next pass of the main loop after the poll that saw it. If the previous frame is still on the wire we leave the
+ * change pending and try again next pass rather than dropping it, so it starts at most one frame time (120us) late and
+ * takes another 120us to arrive. With the stick board's main loop picking it up from the DMA ring, a change reaches
+ * the stick board's state in roughly 300us worst case after that poll, comfortably inside one 1ms USB frame. Add up to
+ * PSX_POLL_US plus the ~0.8ms both polls take for a button, and for position the gun's own once-per-field latch.
+ */
+void link_task(void)
+{
+    static uint64_t link_sent_us = 0;
+    static uint8_t last_payload[sizeof(gun1) + sizeof(gun2)];
+    static bool sent_once = false;
+    static uint8_t seq = 0;
+
+    uint8_t payload[sizeof(gun1) + sizeof(gun2)];
+    memcpy(payload, &gun1, sizeof(gun1));
+    memcpy(payload + sizeof(gun1), &gun2, sizeof(gun2));
+
+    bool changed = !sent_once || memcmp(payload, last_payload, sizeof(payload)) != 0;
+    if (!changed && (time_us_64() - link_sent_us) < LINK_HEARTBEAT_US) return; // nothing to say yet
+
+    if (dma_channel_is_busy(link_dma_chan)) return; // still pending, try again next time round
+
+    size_t len = link_encode(seq++, payload, sizeof(payload), link_frame);
+    dma_channel_transfer_from_buffer_now(link_dma_chan, link_frame, len);
+
+    memcpy(last_payload, payload, sizeof(payload));
+    sent_once = true;
+    link_sent_us = time_us_64();
+}
+
+/**
+ * Set up both controller ports, idle with attention high and the clock high
+ */
+void psx_init(void)
+{
+    for (int p = 0; p < 2; p++) {
+        const psx_port *port = &psx_ports[p];
+        uint outputs[] = { port->cmd, port->att, port->clk };
+        for (int i = 0; i < 3; i++) {
+            gpio_init(outputs[i]);
+            gpio_put(outputs[i], 1);
+            gpio_set_dir(outputs[i], GPIO_OUT);
+        }
+
+        gpio_init(port->dat);
+        gpio_pull_up(port->dat);
+        gpio_init(port->ack);
+        gpio_pull_up(port->ack);
+    }
+}
+
+/**
+ * Clock one byte out and one byte back, LSB first, the gun sampling on the rising edge like we do
+ * Returns whether the gun acked it, i.e. whether it has more to say. The last byte never gets an ack, so don't wait
+ */
+static bool psx_transfer(const psx_port *port, uint8_t out, uint8_t *in, bool last)
+{
+    uint8_t value = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        gpio_put(port->cmd, (out >> bit) & 1);
+        gpio_put(port->clk, 0);
+        busy_wait_us_32(PSX_HALF_BIT_US);
+        gpio_put(port->clk, 1);
+        value |= gpio_get(port->dat) << bit;
+        busy_wait_us_32(PSX_HALF_BIT_US);
+    }
+    *in = value;
+    if (last) return false;
+
+    uint32_t start = time_us_32();
+    while (gpio_get(port->ack)) {
+        if ((time_us_32() - start) > PSX_ACK_TIMEOUT_US) return false;
+    }
+    while (!gpio_get(port->ack)) {
+        if ((time_us_32() - start) > PSX_ACK_TIMEOUT_US) break;
+    }
+    return true;
+}
+
+/**
+ * Read whatever's plugged into a port with the standard poll
+ * Returns how many bytes came back, which is GUNCON_POLL_LEN for a Guncon and less if nothing answered
+ */
+size_t psx_poll(const psx_port *port, uint8_t *resp)
+{
+    const uint8_t cmd[GUNCON_POLL_LEN] = { 0x01, 0x42 };
+    size_t n = 0;
+
+    gpio_put(port->att, 0);
+    busy_wait_us_32(PSX_ACK_TIMEOUT_US / 5); // give it a moment to notice
+
+    while (n < GUNCON_POLL_LEN) {
+        bool more = psx_transfer(port, cmd[n], &resp[n], n == GUNCON_POLL_LEN - 1);
+        n++;
+        if (!more) break;
+    }
+
+    gpio_put(port->att, 1);
+    gpio_put(port->cmd, 1);
+    return n;
+}
+
+/**
+ * Poll the lightguns on each port
+ * Anything that isn't a Guncon, or an empty port, reads as an idle gun
+ */
+void psx_task(void)
+{
+    static uint64_t psx_start_us = 0;
+
+    if ((time_us_64() - psx_start_us) < PSX_POLL_US) return; // not enough time
+    psx_start_us = time_us_64();
+
+    uint8_t resp[GUNCON_POLL_LEN];
+    guncon_decode(resp, psx_poll(&psx_ports[0], resp), &gun1);
+    guncon_decode(resp, psx_poll(&psx_ports[1], resp), &gun2);
+}
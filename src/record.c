@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+#include "record.h"
+
+void record_clear(record_ring *ring)
+{
+    ring->head = 0;
+    ring->count = 0;
+    ring->dropped = 0;
+}
+
+/**
+ * Add an event, dropping the oldest if we're full
+ * Only ever called from one context at a time, so there's no locking here
+ */
+void record_push(record_ring *ring, const record_event *ev)
+{
+    ring->events[ring->head & (RECORD_SIZE - 1)] = *ev;
+    ring->head++;
+    if (ring->count < RECORD_SIZE) {
+        ring->count++;
+    } else {
+        ring->dropped++;
+    }
+}
+
+/**
+ * The i'th oldest event still held, or NULL past the end
+ */
+const record_event *record_at(const record_ring *ring, uint32_t i)
+{
+    if (i >= ring->count) {
+        return NULL;
+    }
+    return &ring->events[(ring->head - ring->count + i) & (RECORD_SIZE - 1)];
+}
+
+/**
+ * Write one event as a line of text (without the newline), with its time made relative to t0_us
+ * Returns the same as snprintf
+ */
+int record_format(const record_event *ev, uint32_t t0_us, char *buf, size_t len)
+{
+    unsigned long t = (unsigned long)(ev->t_us - t0_us);
+
+    if (ev->kind == RECORD_RAW) {
+        return snprintf(buf, len, "%lu %u raw %02x%02x", t, ev->player, ev->data[1], ev->data[0]);
+    }
+    return snprintf(buf, len, "%lu %u %02x%02x%02x%02x", t, ev->player,
+        ev->data[0], ev->data[1], ev->data[2], ev->data[3]);
+}
+
+static bool parse_hex(const char *hex, uint8_t *out, size_t len)
+{
+    if (strlen(hex) != len * 2) return false;
+    for (size_t i = 0; i < len; i++) {
+        unsigned int byte;
+        if (sscanf(hex + i * 2, "%2x", &byte) != 1) return false;
+        out[i] = byte;
+    }
+    return true;
+}
+
+/**
+ * Parse one line of a recording
+ * Returns 1 for an event, 0 for a blank or comment line and -1 if it's malformed
+ */
+int record_parse(const char *line, record_event *ev)
+{
+    char copy[RECORD_LINE_MAX * 2];
+    snprintf(copy, sizeof(copy), "%s", line);
+    char *hash = strchr(copy, '#');
+    if (hash) *hash = '\0';
+
+    unsigned long t;
+    unsigned int player;
+    char a[16], b[16];
+    int fields = sscanf(copy, "%lu %u %15s %15s", &t, &player, a, b);
+    if (fields <= 0) {
+        return 0;
+    }
+
+    memset(ev, 0, sizeof(*ev));
+    ev->t_us = t;
+    ev->player = player;
+
+    if (fields == 3 && parse_hex(a, ev->data, RECORD_REPORT_SIZE)) {
+        ev->kind = RECORD_ACCEPTED;
+        return 1;
+    }
+    if (fields == 4 && strcmp(a, "raw") == 0) {
+        uint8_t state[2];
+        if (!parse_hex(b, state, 2)) return -1;
+        ev->kind = RECORD_RAW;
+        ev->data[0] = state[1];
+        ev->data[1] = state[0];
+        return 1;
+    }
+    return -1;
+}
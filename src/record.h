@@ -0,0 +1,52 @@
+#ifndef _RECORD_H_
+#define _RECORD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Input recording for regression testing
+ *
+ * A fixed size ring of timestamped input events. Raw events are what the expander read back when its /INT fired, so
+ * a recording keeps every bounce; accepted events are the reports that made it through debouncing. When the ring
+ * fills up the oldest events are dropped, so it always holds the most recent part of a session.
+ *
+ * Recordings travel as text, one event per line, '#' starts a comment:
+ *
+ *   <timestamp_us> <player> <report as 8 hex digits>     accepted report
+ *   <timestamp_us> <player> raw <port state as 4 hex>    raw expander read, active low just like the pins
+ *
+ * The accepted lines are the same capture format hidlat replays, and hidlat reads them with this same parser.
+ */
+
+#define RECORD_SIZE         2048    // must be a power of two
+#define RECORD_LINE_MAX     48
+#define RECORD_REPORT_SIZE  4       // sizeof(buttons)
+
+typedef enum {
+    RECORD_RAW = 0,
+    RECORD_ACCEPTED
+} record_kind;
+
+typedef struct {
+    uint32_t t_us;
+    uint8_t player;
+    uint8_t kind;
+    uint8_t data[RECORD_REPORT_SIZE]; // raw: port state in data[0] (low) and data[1] (high); accepted: the report
+} record_event;
+
+typedef struct {
+    record_event events[RECORD_SIZE];
+    uint32_t head;      // total events ever pushed, the ring index is head & (RECORD_SIZE - 1)
+    uint32_t count;     // events currently held
+    uint32_t dropped;   // events overwritten because the ring was full
+} record_ring;
+
+void record_clear(record_ring *ring);
+void record_push(record_ring *ring, const record_event *ev);
+const record_event *record_at(const record_ring *ring, uint32_t i);
+int record_format(const record_event *ev, uint32_t t0_us, char *buf, size_t len);
+int record_parse(const char *line, record_event *ev);
+
+#endif /* _RECORD_H_ */
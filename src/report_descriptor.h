@@ -0,0 +1,38 @@
+#ifndef _REPORT_DESCRIPTOR_H_
+#define _REPORT_DESCRIPTOR_H_
+
+#include <stdint.h>
+
+// HID report descriptor 2 axes, 12 buttons
+// Single Report (no ID) descriptor, matching the layout of the buttons struct in buttons.h
+// Kept free of tinyusb so the host tools can create an identical device with uhid
+static uint8_t const desc_hid_report[] =
+{
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x05,        // Usage (Game Pad)
+    0xA1, 0x01,        // Collection (Application)
+    0x05, 0x01,        //   Usage Page (Generic Desktop Ctrls)
+    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+    0x46, 0xFF, 0x00,  //   Physical Maximum (255)
+    0x09, 0x30,        //   Usage (X)
+    0x09, 0x31,        //   Usage (Y)
+    0x75, 0x08,        //   Report Size (8)
+    0x95, 0x02,        //   Report Count (2)
+    0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x35, 0x00,        //   Physical Minimum (0)
+    0x45, 0x01,        //   Physical Maximum (1)
+    0x75, 0x01,        //   Report Size (1)
+    0x95, 0x0C,        //   Report Count (12)
+    0x05, 0x09,        //   Usage Page (Button)
+    0x19, 0x01,        //   Usage Minimum (0x01)
+    0x29, 0x0C,        //   Usage Maximum (0x09)
+    0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0x95, 0x01,        //   ReportCount(1)
+    0x75, 0x04,        //   ReportSize(4)
+    0x81, 0x03,        //   Input(Constant, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
+    0xC0,              // End Collection
+};
+
+#endif /* _REPORT_DESCRIPTOR_H_ */
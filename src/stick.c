@@ -1,35 +1,24 @@
 #include <stdio.h>
+#include <stdarg.h>
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/structs/usb.h"
 
 #include "bsp/board.h"
 #include "tusb.h"
 #include <stdbool.h>
+#include <string.h>
 
-#define ATTRIBUTE_PACKED  __attribute__((packed, aligned(1)))
-
-/**
- * Struct to hold our HID report data
- * This needs to be tightly packed and optimised in order to pass the correct bit fields defined in usb_descriptors.c
- */
-typedef struct ATTRIBUTE_PACKED {
-    uint8_t x;
-    uint8_t y;
-    bool a:1;
-    bool b:1;
-    bool c:1;
-    bool d:1;
-    bool e:1;
-    bool f:1;
-    bool g:1;
-    bool h:1;
-    bool i:1;
-    bool j:1;
-    bool k:1;
-    bool l:1;
-} buttons;
+#include "buttons.h"
+#include "link.h"
+#include "timing.h"
+#include "turbo.h"
+#include "record.h"
 
 // init these variables with zero'd values
 buttons player1 = {
@@ -65,6 +54,12 @@ buttons player2 = {
     .l = 0
 };
 
+// the psx board's two lightgun ports, fed to us over the inter-board link
+buttons gun1 = BUTTONS_IDLE;
+buttons gun2 = BUTTONS_IDLE;
+// set by link_task when either gun's state changes, so hid_task sends it without waiting for the next interval
+static bool gun_changed = false;
+
 // on board led
 #define LED_PIN     25
 
@@ -76,26 +71,112 @@ buttons player2 = {
 const uint8_t p1_addr = 0x20;
 const uint8_t p2_addr = 0x21;
 
+// inter-board link from the psx board, GP8/GP9 on J3 pins 1/2
+#define LINK_UART       uart1
+#define LINK_TX_PIN     8
+#define LINK_RX_PIN     9
+// how long without a good frame before we assume the psx board has gone away
+#define LINK_TIMEOUT_MS 100
+// the dma ring needs to be a power of two and aligned to its own size
+#define LINK_RING_BITS  8
+#define LINK_RING_SIZE  (1 << LINK_RING_BITS)
+static uint8_t link_ring[LINK_RING_SIZE] __attribute__((aligned(LINK_RING_SIZE)));
+static int link_dma_chan;
+static link_decoder link_rx;
+
+// while a turbo button is held its player's reports are streamed, one per frame, from tud_hid_report_complete_cb()
+turbo_config p1_turbo;
+turbo_config p2_turbo;
+
+// input recording and replay, driven from the usb console in record_task()
+static record_ring recording;
+static volatile bool recording_on = false;
+static uint32_t recording_t0_us;
+// a dump goes out a few lines at a time from record_task(), as the console has room for them
+static bool dumping = false;
+static uint32_t dump_line;
+static volatile bool replaying = false;
+static bool replay_has_raw;
+static uint32_t replay_pos;
+static uint32_t replay_t0_us;
+static bool replay_draining;
+// what each player's expander would read back while replaying
+static volatile uint8_t replay_port[2][2] = {{0xff, 0xff}, {0xff, 0xff}};
+
 void hid_task(void);
 void exp_init(void);
 void exp_read(uint8_t gpio, uint8_t *buf);
 void exp_interrupt(uint gpio, uint32_t event_mask);
 int64_t exp_alarm(alarm_id_t id, void *user_data);
 void player_update(buttons *player, uint16_t state);
+void link_init(void);
+void link_task(void);
+void irq_priority_init(void);
+void timing_task(void);
+void turbo_start(void);
+uint32_t turbo_next_frame(void);
+bool turbo_held(const buttons *player, const turbo_config *turbo);
+void player_report(uint8_t itf, const buttons *player, const turbo_config *turbo);
+int console_printf(const char *fmt, ...);
+void record_task(void);
+void record_command(const char *line);
+void record_dump_task(void);
+void record_input(uint gpio, record_kind kind, const uint8_t *data);
+void replay_start(void);
+void replay_stop(void);
+int64_t replay_alarm(alarm_id_t id, void *user_data);
+int64_t replay_resync(alarm_id_t id, void *user_data);
 
 int main() {
     stdio_init_all();
     board_init();
     exp_init();
+    link_init();
     tusb_init();
+    irq_priority_init();
+    turbo_start();
+    timing_init();
 
     while (1) {
         tud_task();
+        link_task();
         hid_task();
+        timing_task();
+        record_task();
         tight_loop_contents();
     }
 }
 
+/**
+ * In the deterministic timing profile, let usb and the input path preempt everything else
+ * The gpio handler does a blocking i2c read, so usb sits above it to keep the bus serviced
+ */
+void irq_priority_init(void)
+{
+#ifdef DETERMINISTIC_TIMING
+    irq_set_priority(USBCTRL_IRQ, PICO_HIGHEST_IRQ_PRIORITY);
+    irq_set_priority(IO_IRQ_BANK0, PICO_HIGHEST_IRQ_PRIORITY + 0x40);
+    irq_set_priority(TIMER_IRQ_0 + PICO_TIME_DEFAULT_ALARM_POOL_HARDWARE_ALARM_NUM, PICO_HIGHEST_IRQ_PRIORITY + 0x40);
+#endif
+}
+
+/**
+ * Print the worst case cycle counts for the input path every so often
+ * Only does anything in the deterministic timing profile
+ */
+void timing_task(void)
+{
+#ifdef DETERMINISTIC_TIMING
+    const uint32_t interval_ms = 5000;
+    static uint32_t timing_start_ms = 0;
+
+    if ((board_millis() - timing_start_ms) < interval_ms) return; // not enough time
+    timing_start_ms = board_millis();
+
+    timing_report(console_printf);
+#endif
+}
+
 /**
  * Initialise our PCF8575 I/O expanders and associated stuff
  */
@@ -130,6 +211,14 @@ void exp_init(void)
  */
 void exp_read(uint8_t gpio, uint8_t *buf)
 {
+    // when replaying a recording, the expanders are whatever the recording says they are
+    if (replaying) {
+        uint8_t p = (gpio == P2_INT_PIN) ? 1 : 0;
+        buf[0] = replay_port[p][0];
+        buf[1] = replay_port[p][1];
+        return;
+    }
+
     // read from the appropriate i2c address
     uint8_t addr;
     if (gpio == P1_INT_PIN) {
@@ -151,16 +240,19 @@ void exp_interrupt(uint gpio, uint32_t event_mask)
 {
     // just a number plucked out of thin air, but 5ms seems to be fine in practice
     const uint8_t debounce_time_ms = 5;
+    uint32_t cycles = timing_start();
 
     // read two bytes from the expander
     uint8_t new_state[2] = {255,255};
     exp_read(gpio, new_state);
+    record_input(gpio, RECORD_RAW, new_state);
 
     // pack our state data and gpio pin into a uint to pass to the alarm
     uint32_t alarm_data = (new_state[1] << 16) | (new_state[0] << 8) | gpio;
 
     // set an alarm and send the gpio to the alarm handler
     add_alarm_in_ms(debounce_time_ms, exp_alarm, (void *)(uintptr_t)alarm_data, false);
+    timing_end(TIMING_EXP_INTERRUPT, cycles);
 }
 
 /**
@@ -169,6 +261,8 @@ void exp_interrupt(uint gpio, uint32_t event_mask)
  */
 int64_t exp_alarm(alarm_id_t id, void *user_data)
 {
+    uint32_t cycles = timing_start();
+
     // extract out our gpio and state data back out from the alarm data
     uint32_t data = (uintptr_t)user_data;
     uint gpio = data & 0xFF;
@@ -181,6 +275,7 @@ int64_t exp_alarm(alarm_id_t id, void *user_data)
 
     if (first_state ^ second_state) {
         // differences between interrupt state and alarm state, so ignore this bounce
+        timing_end(TIMING_EXP_ALARM, cycles);
         return 0;
     }
 
@@ -195,7 +290,9 @@ int64_t exp_alarm(alarm_id_t id, void *user_data)
     } else if (gpio == P2_INT_PIN) {
         player_update(&player2, second_state);
     }
+    record_input(gpio, RECORD_ACCEPTED, (const uint8_t *)(gpio == P2_INT_PIN ? &player2 : &player1));
 
+    timing_end(TIMING_EXP_ALARM, cycles);
     return 0;
 }
 
@@ -236,6 +333,356 @@ void player_update(buttons *player, uint16_t state)
     player->l = state & (1 << 15);
 }
 
+/**
+ * Set up the UART from the psx board
+ * Received bytes are streamed by DMA into a ring buffer so nothing is lost while the cpu is busy elsewhere
+ */
+void link_init(void)
+{
+    uart_init(LINK_UART, LINK_BAUD);
+    gpio_set_function(LINK_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(LINK_RX_PIN, GPIO_FUNC_UART);
+    uart_set_fifo_enabled(LINK_UART, true);
+
+    link_decoder_init(&link_rx);
+
+    link_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(link_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, LINK_RING_BITS);
+    channel_config_set_dreq(&c, uart_get_dreq(LINK_UART, false));
+
+    dma_channel_configure(link_dma_chan, &c,
+        link_ring,
+        &uart_get_hw(LINK_UART)->dr,
+        0xffffffff, // effectively forever, but link_task re-arms it if it ever runs out
+        true
+    );
+}
+
+/**
+ * Drain whatever the DMA has written since last time and run it through the frame decoder
+ * The newest good frame from the psx board replaces the state of both lightgun ports
+ */
+void link_task(void)
+{
+    static uint32_t tail = 0;
+    static uint32_t last_frame_ms = 0;
+
+    if (!dma_channel_is_busy(link_dma_chan)) {
+        dma_channel_set_trans_count(link_dma_chan, 0xffffffff, true);
+    }
+
+    uint32_t head = ((uintptr_t)dma_channel_hw_addr(link_dma_chan)->write_addr - (uintptr_t)link_ring) & (LINK_RING_SIZE - 1);
+    while (tail != head) {
+        if (link_decode_byte(&link_rx, link_ring[tail]) && link_rx.len == sizeof(gun1) + sizeof(gun2)) {
+            if (memcmp(&gun1, link_rx.payload, sizeof(gun1)) || memcmp(&gun2, link_rx.payload + sizeof(gun1), sizeof(gun2))) {
+                memcpy(&gun1, link_rx.payload, sizeof(gun1));
+                memcpy(&gun2, link_rx.payload + sizeof(gun1), sizeof(gun2));
+                gun_changed = true;
+            }
+            last_frame_ms = board_millis();
+        }
+        tail = (tail + 1) & (LINK_RING_SIZE - 1);
+    }
+
+    // no news from the psx board for a while, so let go of everything rather than leave a trigger held
+    if ((board_millis() - last_frame_ms) > LINK_TIMEOUT_MS) {
+        const buttons idle = BUTTONS_IDLE;
+        if (memcmp(&gun1, &idle, sizeof(idle)) || memcmp(&gun2, &idle, sizeof(idle))) {
+            gun1 = idle;
+            gun2 = idle;
+            gun_changed = true;
+        }
+    }
+}
+
+/**
+ * Set up which buttons have autofire
+ */
+void turbo_start(void)
+{
+    turbo_init(&p1_turbo);
+    turbo_init(&p2_turbo);
+
+    // no autofire by default, but e.g. this would put player 1's a and b on 15Hz turbo
+    // turbo_set(&p1_turbo, (1 << 0) | (1 << 1), TURBO_15HZ);
+}
+
+/**
+ * The usb frame a report queued right now will go out in, as a running count
+ * Only ever called from the main loop, which comes round far more often than the 11 bit SOF counter wraps
+ */
+uint32_t turbo_next_frame(void)
+{
+    static turbo_frame_counter counter = {0};
+    return turbo_frame_update(&counter, usb_hw->sof_rd & USB_SOF_RD_BITS) + 1;
+}
+
+/**
+ * Whether a player is holding any button that has turbo on
+ */
+bool turbo_held(const buttons *player, const turbo_config *turbo)
+{
+    const uint8_t *raw = (const uint8_t *)player;
+    return ((raw[2] | (raw[3] << 8)) & turbo_buttons(turbo)) != 0;
+}
+
+/**
+ * Add an input event to the recording, if we're recording
+ * Called from the gpio and alarm handlers, which never preempt each other
+ */
+void record_input(uint gpio, record_kind kind, const uint8_t *data)
+{
+    if (!recording_on) return;
+
+    record_event ev = {
+        .t_us = time_us_32(),
+        .player = (gpio == P2_INT_PIN) ? 2 : 1,
+        .kind = kind
+    };
+    memcpy(ev.data, data, kind == RECORD_RAW ? 2 : RECORD_REPORT_SIZE);
+    record_push(&recording, &ev);
+}
+
+/**
+ * printf to the usb console, the cdc interface alongside the two players
+ * Never waits on the host: output is thrown away while nothing has the port open, or if there isn't room for all of
+ * it, so a program that opens the port and never reads it can't hold up the input path. Returns what was written.
+ */
+int console_printf(const char *fmt, ...)
+{
+    char buf[128];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (len <= 0 || !tud_cdc_connected()) return 0;
+    if (len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
+    if (tud_cdc_write_available() < (uint32_t)len) return 0; // whole lines or nothing
+
+    tud_cdc_write(buf, len);
+    tud_cdc_write_flush();
+    return len;
+}
+
+/**
+ * Read commands a line at a time from the usb console
+ *
+ *   record    start a fresh recording
+ *   stop      stop recording or replaying
+ *   dump      print the recording, in the format record.h describes
+ *   load      replace the recording with the lines that follow, up to a line saying "end"
+ *   replay    play the recording back in place of the expanders
+ */
+void record_task(void)
+{
+    static char line[RECORD_LINE_MAX];
+    static uint8_t len = 0;
+
+    int32_t c;
+    while ((c = tud_cdc_read_char()) >= 0) {
+        if (c == '\r' || c == '\n') {
+            line[len] = '\0';
+            if (len) record_command(line);
+            len = 0;
+        } else if (len < sizeof(line) - 1) {
+            line[len++] = c;
+        }
+    }
+
+    record_dump_task();
+}
+
+/**
+ * Send as much of a dump as the console has room for right now, carrying on from where the last call got to
+ * Line 0 is the header, then one per event, then the end marker
+ */
+void record_dump_task(void)
+{
+    if (!dumping) return;
+    if (!tud_cdc_connected()) {
+        dumping = false; // nobody's listening any more
+        return;
+    }
+
+    char buf[RECORD_LINE_MAX];
+    while (dumping && tud_cdc_write_available() > RECORD_LINE_MAX) {
+        const record_event *ev;
+        if (dump_line == 0) {
+            console_printf("# %lu events, %lu dropped\n", (unsigned long)recording.count,
+                (unsigned long)recording.dropped);
+        } else if ((ev = record_at(&recording, dump_line - 1))) {
+            record_format(ev, recording_t0_us, buf, sizeof(buf));
+            console_printf("%s\n", buf);
+        } else {
+            console_printf("# end\n");
+            dumping = false;
+        }
+        dump_line++;
+    }
+}
+
+void record_command(const char *line)
+{
+    static bool loading = false;
+
+    if (loading) {
+        if (strcmp(line, "end") == 0) {
+            loading = false;
+            console_printf("# loaded %lu events\n", (unsigned long)recording.count);
+            return;
+        }
+
+        record_event ev;
+        int ret = record_parse(line, &ev);
+        if (ret < 0) {
+            console_printf("# bad line: %s\n", line);
+        } else if (ret > 0) {
+            record_push(&recording, &ev);
+        }
+        return;
+    }
+
+    if (strcmp(line, "record") == 0) {
+        dumping = false;
+        replay_stop();
+        recording_on = false;
+        record_clear(&recording);
+        recording_t0_us = time_us_32();
+        recording_on = true;
+    } else if (strcmp(line, "stop") == 0) {
+        recording_on = false;
+        replay_stop();
+    } else if (strcmp(line, "dump") == 0) {
+        recording_on = false;
+        dump_line = 0;
+        dumping = true;
+    } else if (strcmp(line, "load") == 0) {
+        dumping = false;
+        recording_on = false;
+        replay_stop();
+        record_clear(&recording);
+        recording_t0_us = 0;
+        loading = true;
+    } else if (strcmp(line, "replay") == 0) {
+        recording_on = false;
+        replay_start();
+    } else {
+        console_printf("# unknown command: %s\n", line);
+    }
+}
+
+/**
+ * Take the expanders out of the loop and start feeding the recording in on its own timeline
+ * Raw reads go through the real debounce path, so a recording with bounce in it tests the debounce too; a recording
+ * with only accepted reports in it gets those put straight into the player state instead
+ */
+void replay_start(void)
+{
+    if (replaying || recording.count == 0) return;
+
+    replay_has_raw = false;
+    const record_event *ev;
+    for (uint32_t i = 0; (ev = record_at(&recording, i)); i++) {
+        if (ev->kind == RECORD_RAW) {
+            replay_has_raw = true;
+            break;
+        }
+    }
+
+    gpio_set_irq_enabled(P1_INT_PIN, GPIO_IRQ_EDGE_FALL, false);
+    gpio_set_irq_enabled(P2_INT_PIN, GPIO_IRQ_EDGE_FALL, false);
+
+    replay_pos = 0;
+    replay_draining = false;
+    replay_t0_us = time_us_32() - record_at(&recording, 0)->t_us;
+    replaying = true;
+    add_alarm_in_us(0, replay_alarm, NULL, true);
+}
+
+void replay_stop(void)
+{
+    if (!replaying) return;
+
+    replaying = false;
+    replay_draining = false;
+
+    // hand back to the expanders from an alarm, so the reads can't land on the i2c bus alongside a debounce alarm's
+    add_alarm_in_us(0, replay_resync, NULL, true);
+}
+
+/**
+ * Alarm handler set by replay_stop()
+ * Anything that changed on the real inputs while replaying never made it through, so read both expanders afresh,
+ * which also clears any /INT they've been holding low, before listening to them again
+ */
+int64_t replay_resync(alarm_id_t id, void *user_data)
+{
+    (void) id;
+    (void) user_data;
+
+    if (replaying) return 0; // a new replay started before we got here, so the expanders stay out of it
+
+    uint8_t state[2];
+    exp_read(P1_INT_PIN, state);
+    uint16_t p1_state = ~((state[1] << 8) | state[0]);
+    exp_read(P2_INT_PIN, state);
+    uint16_t p2_state = ~((state[1] << 8) | state[0]);
+
+    player_update(&player1, p1_state);
+    player_update(&player2, p2_state);
+    gpio_put(LED_PIN, (p1_state | p2_state) > 0);
+
+    gpio_set_irq_enabled(P1_INT_PIN, GPIO_IRQ_EDGE_FALL, true);
+    gpio_set_irq_enabled(P2_INT_PIN, GPIO_IRQ_EDGE_FALL, true);
+    return 0;
+}
+
+/**
+ * Alarm handler that plays every event that's due, then sleeps until the next one
+ */
+int64_t replay_alarm(alarm_id_t id, void *user_data)
+{
+    (void) id;
+    (void) user_data;
+
+    if (!replaying) return 0;
+
+    const record_event *ev;
+    while ((ev = record_at(&recording, replay_pos)) && (int32_t)(time_us_32() - replay_t0_us - ev->t_us) >= 0) {
+        uint gpio = (ev->player == 2) ? P2_INT_PIN : P1_INT_PIN;
+        buttons *player = (ev->player == 2) ? &player2 : &player1;
+
+        if (ev->kind == RECORD_RAW) {
+            // as if the expander's /INT had just fallen
+            uint8_t p = (ev->player == 2) ? 1 : 0;
+            replay_port[p][0] = ev->data[0];
+            replay_port[p][1] = ev->data[1];
+            exp_interrupt(gpio, GPIO_IRQ_EDGE_FALL);
+        } else if (!replay_has_raw) {
+            memcpy(player, ev->data, sizeof(buttons));
+        }
+        replay_pos++;
+    }
+
+    if (!ev) {
+        // leave a moment for the last debounce alarm to see the final state before handing back to the expanders
+        if (!replay_draining) {
+            replay_draining = true;
+            return 10 * 1000;
+        }
+        replay_stop();
+        return 0;
+    }
+
+    int32_t wait = (int32_t)(ev->t_us + replay_t0_us - time_us_32());
+    return wait > 0 ? wait : 1;
+}
+
 //--------------------------------------------------------------------+
 // Device callbacks
 //--------------------------------------------------------------------+
@@ -267,7 +714,9 @@ void tud_resume_cb(void) {
 //--------------------------------------------------------------------+
 enum {
   ITF_PLAYER_1 = 0,
-  ITF_PLAYER_2 = 1
+  ITF_PLAYER_2 = 1,
+  ITF_GUN_1 = 2,
+  ITF_GUN_2 = 3
 };
 
 void hid_task(void) {
@@ -275,7 +724,11 @@ void hid_task(void) {
     const uint32_t interval_ms = 100;
     static uint32_t hid_start_ms = 0;
 
-    if ((board_millis() - hid_start_ms) < interval_ms) return; // not enough time
+    // a turbo button going down starts its player's stream straight away, and a gun moving can't wait either
+    // while a stream is running its endpoint is never ready here, since the next report is queued as the last completes
+    bool turbo_start_stream = (turbo_held(&player1, &p1_turbo) && tud_hid_n_ready(ITF_PLAYER_1)) ||
+                              (turbo_held(&player2, &p2_turbo) && tud_hid_n_ready(ITF_PLAYER_2));
+    if (!turbo_start_stream && !gun_changed && (board_millis() - hid_start_ms) < interval_ms) return; // not enough time
     hid_start_ms = board_millis() + interval_ms;
 
     // Remote wakeup
@@ -285,15 +738,62 @@ void hid_task(void) {
         tud_remote_wakeup();
     }
 
+    uint32_t cycles = timing_start();
+
+    if (tud_hid_n_ready(ITF_GUN_1) && tud_hid_n_ready(ITF_GUN_2)) {
+        gun_changed = false;
+    }
+
     /*------------- Player 1 -------------*/
     if (tud_hid_n_ready(ITF_PLAYER_1)) {
-        tud_hid_n_report(ITF_PLAYER_1, 0x00, &player1, sizeof(player1));
+        player_report(ITF_PLAYER_1, &player1, &p1_turbo);
     }
     /*------------- Player 2 -------------*/
     if (tud_hid_n_ready(ITF_PLAYER_2)) {
-        tud_hid_n_report(ITF_PLAYER_2, 0x00, &player2, sizeof(player2));
+        player_report(ITF_PLAYER_2, &player2, &p2_turbo);
+    }
+    /*------------- Lightgun 1 -------------*/
+    if (tud_hid_n_ready(ITF_GUN_1)) {
+        tud_hid_n_report(ITF_GUN_1, 0x00, &gun1, sizeof(gun1));
+    }
+    /*------------- Lightgun 2 -------------*/
+    if (tud_hid_n_ready(ITF_GUN_2)) {
+        tud_hid_n_report(ITF_GUN_2, 0x00, &gun2, sizeof(gun2));
     }
 
+    timing_end(TIMING_HID_REPORT, cycles);
+
+}
+
+/**
+ * Send a player's report with any turbo buttons that are in their off phase released
+ * The action buttons sit in the last two bytes of the report, a in the lowest bit, same as the turbo masks
+ */
+void player_report(uint8_t itf, const buttons *player, const turbo_config *turbo)
+{
+    uint16_t release = turbo_release_mask(turbo, turbo_next_frame());
+    buttons report = *player;
+    uint8_t *raw = (uint8_t *)&report;
+    raw[2] &= ~(release & 0xFF);
+    raw[3] &= ~(release >> 8);
+
+    tud_hid_n_report(itf, 0x00, &report, sizeof(report));
+}
+
+// Invoked when a report has gone out to the host, i.e. during the frame the host just polled
+// While a player holds a turbo button, queue their next report straight away, worked out for the next frame, so every
+// toggle goes out on exactly the frame its phase changes. One more goes after letting go, so the host sees the release
+void tud_hid_report_complete_cb(uint8_t itf, uint8_t const* report, uint16_t len) {
+    (void) len;
+    if (itf != ITF_PLAYER_1 && itf != ITF_PLAYER_2) return;
+
+    const buttons *player = (itf == ITF_PLAYER_1) ? &player1 : &player2;
+    const turbo_config *turbo = (itf == ITF_PLAYER_1) ? &p1_turbo : &p2_turbo;
+    bool sent_turbo = ((report[2] | (report[3] << 8)) & turbo_buttons(turbo)) != 0;
+
+    if (turbo_held(player, turbo) || sent_turbo) {
+        player_report(itf, player, turbo);
+    }
 }
 
 // Invoked when received GET_REPORT control request
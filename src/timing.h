@@ -0,0 +1,91 @@
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+#include <stdint.h>
+
+/**
+ * Cycle counting for the deterministic timing build profile (-DDETERMINISTIC_TIMING=ON)
+ *
+ * The M0+ has no cycle counter, so this borrows SysTick running from the processor clock. It's 24 bits wide, which
+ * wraps after ~134ms at 125MHz, so it's only good for timing short paths, which is exactly what we want it for.
+ * Each segment keeps its worst case seen since boot, and timing_report() prints them next to their budgets through
+ * whatever printf-alike it's given (the stick board's usb console).
+ *
+ * The budgets are worked out rather than measured, at the default 125MHz. Reading a PCF8575 is an address byte and two
+ * data bytes with their acks, plus start and stop, so about 29 bit times at 400kHz: 72.5us, or ~9k cycles spent
+ * waiting on the bus. Each expander segment gets that plus ~1k for everything around it. A report is two small
+ * endpoint buffer copies and a bit of tinyusb bookkeeping, so a couple of thousand cycles covers both players. That
+ * puts the whole edge-to-report path at ~22k cycles, or ~180us of cpu.
+ *
+ * In a normal build all of this compiles away to nothing.
+ */
+
+typedef enum {
+    TIMING_EXP_INTERRUPT = 0,  // gpio edge to alarm set, including the first i2c read
+    TIMING_EXP_ALARM,          // debounce alarm, second i2c read and player_update
+    TIMING_HID_REPORT,         // building and queueing all the reports in hid_task
+    TIMING_NUM
+} timing_segment;
+
+typedef int (*timing_printf)(const char *fmt, ...);
+
+#ifdef DETERMINISTIC_TIMING
+
+#include "hardware/structs/systick.h"
+
+static const char *timing_names[TIMING_NUM] = {
+    "exp_interrupt",
+    "exp_alarm",
+    "hid_report"
+};
+static const uint32_t timing_budget[TIMING_NUM] = {
+    10000,
+    10000,
+    2000
+};
+static volatile uint32_t timing_worst[TIMING_NUM];
+
+static inline void timing_init(void)
+{
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // enable, processor clock, no interrupt
+}
+
+static inline uint32_t timing_start(void)
+{
+    return systick_hw->cvr;
+}
+
+static inline void timing_end(timing_segment seg, uint32_t start)
+{
+    // systick counts down
+    uint32_t cycles = (start - systick_hw->cvr) & 0x00FFFFFF;
+    if (cycles > timing_worst[seg]) {
+        timing_worst[seg] = cycles;
+    }
+}
+
+static inline void timing_report(timing_printf print)
+{
+    uint32_t total = 0, total_budget = 0;
+    for (int i = 0; i < TIMING_NUM; i++) {
+        print("%-14s worst %6lu cycles, budget %6lu%s\n", timing_names[i], (unsigned long)timing_worst[i],
+            (unsigned long)timing_budget[i], timing_worst[i] > timing_budget[i] ? " OVER" : "");
+        total += timing_worst[i];
+        total_budget += timing_budget[i];
+    }
+    print("%-14s worst %6lu cycles, budget %6lu%s\n", "edge-to-report", (unsigned long)total,
+        (unsigned long)total_budget, total > total_budget ? " OVER" : "");
+}
+
+#else
+
+static inline void timing_init(void) {}
+static inline uint32_t timing_start(void) { return 0; }
+static inline void timing_end(timing_segment seg, uint32_t start) { (void) seg; (void) start; }
+static inline void timing_report(timing_printf print) { (void) print; }
+
+#endif
+
+#endif /* _TIMING_H_ */
@@ -0,0 +1,68 @@
+#include "turbo.h"
+
+static const uint8_t turbo_half_period[TURBO_NUM_RATES] = {
+    17, // TURBO_30HZ
+    25, // TURBO_20HZ
+    33, // TURBO_15HZ
+    50  // TURBO_10HZ
+};
+
+void turbo_init(turbo_config *turbo)
+{
+    for (int r = 0; r < TURBO_NUM_RATES; r++) {
+        turbo->rate_mask[r] = 0;
+    }
+}
+
+/**
+ * Put the given buttons on a turbo rate, or take them off turbo with TURBO_OFF
+ * A button can only be on one rate at a time, so it's removed from all the others first
+ */
+void turbo_set(turbo_config *turbo, uint16_t buttons, turbo_rate rate)
+{
+    for (int r = 0; r < TURBO_NUM_RATES; r++) {
+        turbo->rate_mask[r] &= ~buttons;
+    }
+    if (rate < TURBO_NUM_RATES) {
+        turbo->rate_mask[rate] |= buttons;
+    }
+}
+
+/**
+ * Every button that has turbo on, whatever its rate
+ */
+uint16_t turbo_buttons(const turbo_config *turbo)
+{
+    uint16_t mask = 0;
+    for (int r = 0; r < TURBO_NUM_RATES; r++) {
+        mask |= turbo->rate_mask[r];
+    }
+    return mask;
+}
+
+/**
+ * Fold a fresh reading of the SOF counter into the running frame count and return it
+ * Has to be called at least once every 2048 frames, or whole wraps go missing
+ */
+uint32_t turbo_frame_update(turbo_frame_counter *counter, uint16_t sof)
+{
+    sof &= TURBO_SOF_MASK;
+    counter->frame += (sof - counter->last_sof) & TURBO_SOF_MASK;
+    counter->last_sof = sof;
+    return counter->frame;
+}
+
+/**
+ * Which turbo buttons should read as released during the given USB frame
+ * The frame number must keep counting past the 11 bit SOF counter, otherwise every wrap would glitch the phase
+ */
+uint16_t turbo_release_mask(const turbo_config *turbo, uint32_t frame)
+{
+    uint16_t mask = 0;
+    for (int r = 0; r < TURBO_NUM_RATES; r++) {
+        if ((frame / turbo_half_period[r]) & 1) {
+            mask |= turbo->rate_mask[r];
+        }
+    }
+    return mask;
+}
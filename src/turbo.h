@@ -0,0 +1,58 @@
+#ifndef _TURBO_H_
+#define _TURBO_H_
+
+#include <stdint.h>
+
+/**
+ * Turbo/autofire engine
+ *
+ * Rather than keep a timer per button, buttons are grouped by rate: each rate has a mask of the buttons using it, and
+ * its on/off phase comes straight from the USB frame number. Working out which buttons to let go of is then one
+ * divide and one OR per rate, the same cost whether one button has turbo on or all twelve do.
+ *
+ * The phase comes from the host's own start-of-frame count, and while a turbo button is held the stick board queues
+ * each report as the previous one completes, worked out for the frame it'll go out in. So as long as the main loop
+ * gets to that completion before the frame ends, every toggle reaches the host in exactly the frame it's due; a main
+ * loop held up past the frame boundary puts that one toggle a frame late (never early), and the first report after a
+ * press isn't tied to a frame at all. It's ±1 frame in the worst case, not a beat against the host's polling.
+ *
+ * That also relies on the host polling every frame, which is why the player interfaces ask for a 1ms bInterval. With
+ * a longer interval the odd half periods below would land between polls and each toggle would be seen up to an
+ * interval late, unevenly.
+ *
+ * Masks use the same bit order as the action buttons in buttons.h, so bit 0 is a and bit 11 is l.
+ *
+ * host/turbocheck.c holds this to a per-button reference across the SOF counter wrapping, and checks nothing without
+ * turbo on is ever released.
+ */
+
+// half a turbo cycle in 1ms USB frames, so each button spends this long pressed then this long released
+typedef enum {
+    TURBO_30HZ = 0,  // 17 frames, ~29.4Hz
+    TURBO_20HZ,      // 25 frames
+    TURBO_15HZ,      // 33 frames, ~15.2Hz
+    TURBO_10HZ,      // 50 frames
+    TURBO_NUM_RATES,
+    TURBO_OFF = TURBO_NUM_RATES
+} turbo_rate;
+
+typedef struct {
+    uint16_t rate_mask[TURBO_NUM_RATES];
+} turbo_config;
+
+// the hardware SOF frame counter is only 11 bits
+#define TURBO_SOF_MASK  0x07FF
+
+// running frame count extended from the SOF counter, so the turbo phase carries on smoothly through each wrap
+typedef struct {
+    uint16_t last_sof;
+    uint32_t frame;
+} turbo_frame_counter;
+
+void turbo_init(turbo_config *turbo);
+void turbo_set(turbo_config *turbo, uint16_t buttons, turbo_rate rate);
+uint16_t turbo_buttons(const turbo_config *turbo);
+uint16_t turbo_release_mask(const turbo_config *turbo, uint32_t frame);
+uint32_t turbo_frame_update(turbo_frame_counter *counter, uint16_t sof);
+
+#endif /* _TURBO_H_ */
@@ -77,8 +77,18 @@ extern "C" {
 #endif
 
 //------------- CLASS -------------//
+// the stick board adds the psx board's two lightguns (USB_LIGHTGUNS) after its two players
+#ifdef USB_LIGHTGUNS
+#define CFG_TUD_HID             4
+#else
 #define CFG_TUD_HID             2
+#endif
+// only the stick board has a usb console (USB_CONSOLE), the vga board shares these descriptors without one
+#ifdef USB_CONSOLE
+#define CFG_TUD_CDC             1
+#else
 #define CFG_TUD_CDC             0
+#endif
 #define CFG_TUD_MSC             0
 #define CFG_TUD_MIDI            0
 #define CFG_TUD_VENDOR          0
@@ -86,6 +96,13 @@ extern "C" {
 // HID buffer size Should be sufficient to hold ID (if any) + Data
 #define CFG_TUD_HID_BUFSIZE     16
 
+// CDC FIFO size of TX and RX, big enough for a whole line of a recording dump each way
+#define CFG_TUD_CDC_RX_BUFSIZE  64
+#define CFG_TUD_CDC_TX_BUFSIZE  256
+
+// CDC Endpoint transfer buffer size, more is faster
+#define CFG_TUD_CDC_EP_BUFSIZE  64
+
 #ifdef __cplusplus
 }
 #endif
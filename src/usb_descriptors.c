@@ -28,17 +28,8 @@
  */
 
 #include "tusb.h"
-// #include "usb_descriptors.h"
-
-/* A combination of interfaces must have a unique product id, since PC will save device driver after the first plug.
- * Same VID/PID with different interface e.g MSC (first), then CDC (later) will possibly cause system error on PC.
- *
- * Auto ProductID layout's Bitmap:
- *   [MSB]         HID | MSC | CDC          [LSB]
- */
-#define _PID_MAP(itf, n)  ( (CFG_TUD_##itf) << (n) )
-#define USB_PID           (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(MSC, 1) | _PID_MAP(HID, 2) | \
-                           _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4) )
+#include "report_descriptor.h"
+#include "usb_descriptors.h"
 
 //--------------------------------------------------------------------+
 // Device Descriptors
@@ -48,12 +39,19 @@ tusb_desc_device_t const desc_device =
                 .bLength            = sizeof(tusb_desc_device_t),
                 .bDescriptorType    = TUSB_DESC_DEVICE,
                 .bcdUSB             = 0x0200,
+#if CFG_TUD_CDC
+                // the cdc function comes with an interface association, so say so or windows won't bind it
+                .bDeviceClass       = TUSB_CLASS_MISC,
+                .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+                .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+#else
                 .bDeviceClass       = 0x00,
                 .bDeviceSubClass    = 0x00,
                 .bDeviceProtocol    = 0x00,
+#endif
                 .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
 
-                .idVendor           = 0xCafe,
+                .idVendor           = USB_VID,
                 .idProduct          = USB_PID,
                 .bcdDevice          = 0x0100,
 
@@ -74,36 +72,7 @@ uint8_t const *tud_descriptor_device_cb(void) {
 // HID Report Descriptor
 //--------------------------------------------------------------------+
 
-// HID report descriptor 2 axes, 9 buttons
-// Single Report (no ID) descriptor
-uint8_t const desc_hid_report[] =
-{
-    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
-    0x09, 0x05,        // Usage (Game Pad)
-    0xA1, 0x01,        // Collection (Application)
-    0x05, 0x01,        //   Usage Page (Generic Desktop Ctrls)
-    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
-    0x46, 0xFF, 0x00,  //   Physical Maximum (255)
-    0x09, 0x30,        //   Usage (X)
-    0x09, 0x31,        //   Usage (Y)
-    0x75, 0x08,        //   Report Size (8)
-    0x95, 0x02,        //   Report Count (2)
-    0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x25, 0x01,        //   Logical Maximum (1)
-    0x35, 0x00,        //   Physical Minimum (0)
-    0x45, 0x01,        //   Physical Maximum (1)
-    0x75, 0x01,        //   Report Size (1)
-    0x95, 0x0C,        //   Report Count (12)
-    0x05, 0x09,        //   Usage Page (Button)
-    0x19, 0x01,        //   Usage Minimum (0x01)
-    0x29, 0x0C,        //   Usage Maximum (0x09)
-    0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
-    0x95, 0x01,        //   ReportCount(1)
-    0x75, 0x04,        //   ReportSize(4)
-    0x81, 0x03,        //   Input(Constant, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, BitField)
-    0xC0,              // End Collection
-};
+// HID report descriptor lives in report_descriptor.h so host tools can share it
 
 
 // // Invoked when received GET HID REPORT DESCRIPTOR
@@ -120,13 +89,27 @@ uint8_t const * tud_hid_descriptor_report_cb(uint8_t itf)
 enum {
     ITF_NUM_HID1,
     ITF_NUM_HID2,
+#ifdef USB_LIGHTGUNS
+    ITF_NUM_HID3,
+    ITF_NUM_HID4,
+#endif
+#if CFG_TUD_CDC
+    ITF_NUM_CDC,
+    ITF_NUM_CDC_DATA,
+#endif
     ITF_NUM_TOTAL
 };
 
-#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_HID_DESC_LEN)
+#define  CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + (CFG_TUD_HID * TUD_HID_DESC_LEN) + (CFG_TUD_CDC * TUD_CDC_DESC_LEN))
 
 #define EPNUM_HID1   0x81
 #define EPNUM_HID2   0x82
+#define EPNUM_HID3   0x83
+#define EPNUM_HID4   0x84
+// console for record/replay and timing reports
+#define EPNUM_CDC_NOTIF  0x85
+#define EPNUM_CDC_OUT    0x06
+#define EPNUM_CDC_IN     0x86
 
 
 uint8_t const desc_configuration[] =
@@ -135,8 +118,18 @@ uint8_t const desc_configuration[] =
   TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
 
   // Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID1, 4, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID1, CFG_TUD_HID_EP_BUFSIZE, 10),
-  TUD_HID_DESCRIPTOR(ITF_NUM_HID2, 5, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID2, CFG_TUD_HID_EP_BUFSIZE, 10)
+  // polled every frame, so turbo phase changes (counted in frames, see turbo.h) reach the host the frame they happen
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID1, 4, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID1, CFG_TUD_HID_EP_BUFSIZE, 1),
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID2, 5, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID2, CFG_TUD_HID_EP_BUFSIZE, 1),
+#ifdef USB_LIGHTGUNS
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID3, 6, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID3, CFG_TUD_HID_EP_BUFSIZE, 1),
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID4, 7, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID4, CFG_TUD_HID_EP_BUFSIZE, 1),
+#endif
+
+#if CFG_TUD_CDC
+  // Interface number, string index, EP notification address and size, EP data address (out, in) and size
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 8, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64)
+#endif
 };
 
 // Invoked when received GET CONFIGURATION DESCRIPTOR
@@ -159,7 +152,10 @@ char const *string_desc_arr[] =
                 "TinyUSB Joystick",            // 2: Product
                 "123456",                      // 3: Serials, should use chip ID
                 "Player 1 Joystick",
-                "Player 2 Joystick"
+                "Player 2 Joystick",
+                "Player 1 Lightgun",
+                "Player 2 Lightgun",
+                "Console"
         };
 
 static uint16_t _desc_str[32];
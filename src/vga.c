@@ -3,14 +3,31 @@
 #include "pico/time.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/pio.h"
 
 #include "bsp/board.h"
 #include "tusb.h"
 
+#include "csync.h"
+#ifdef CSYNC_REGEN
+#include "csync.pio.h"
+#endif
+
 #define SDA_PIN 0
 #define SCL_PIN 1
 #define BLK_PIN 2
 
+/**
+ * Optional composite sync regeneration (-DCSYNC_REGEN=ON)
+ * Needs the VGA hsync and vsync level shifted down to 3.3V onto these pins, and the csync pin wired in place of
+ * the 74LS86's output
+ */
+#define HSYNC_PIN 3
+#define VSYNC_PIN 4
+#define CSYNC_PIN 5
+// vsync is far too slow to count at full speed in 16 bits, so its measurement runs at 1/64 of the clock
+#define VSYNC_MEASURE_DIV 64
+
 /**
  * Values to control the TDA935x I2C RGB blanking setting
  */
@@ -22,25 +39,31 @@ void hid_task(void);
 void crt_init(void);
 void crt_task(void);
 void crt_rgb_enable(void);
+void csync_init(void);
+void csync_task(void);
+void csync_wait_ms(uint32_t ms);
 
 int main() {
     stdio_init_all();
     crt_init();
+    csync_init();
     // board_init();
     // tusb_init();
 
     // we only seem to need to do this once at startup, once the tv has warmed up
     // give the system about 10 seconds to get past VGA post stuff not in 15khz then proceed
-    sleep_ms(10000);
+    // csync has to keep up with the incoming syncs the whole time, so keep it serviced while we wait
+    csync_wait_ms(10000);
     crt_rgb_enable();
 
-    sleep_ms(500);
+    csync_wait_ms(500);
     // start rgb blanking
     gpio_put(BLK_PIN, 1);
 
     while (1) {
         // tud_task();
         crt_task();
+        csync_task();
         // hid_task();
     }
 
@@ -88,6 +111,132 @@ void crt_rgb_enable(void) {
     i2c_write_blocking(i2c_default, tda935x_addr, buf, 2, false);
 }
 
+#ifdef CSYNC_REGEN
+static PIO csync_pio = pio0;
+static uint hsync_measure_sm;
+static uint vsync_measure_sm;
+static uint csync_sm;
+static bool hsync_inverted = true;  // most PCs send negative sync, so start by assuming that
+static bool vsync_inverted = true;
+static uint32_t csync_broad;        // broad pulse length the csync program was last given
+static csync_filter hsync_filter;
+static csync_filter vsync_filter;
+
+static void measure_sm_init(uint sm, uint offset, uint pin, float div)
+{
+    pio_sm_config c = sync_measure_program_get_default_config(offset);
+    sm_config_set_in_pins(&c, pin);
+    sm_config_set_jmp_pin(&c, pin);
+    sm_config_set_in_shift(&c, false, false, 32);
+    sm_config_set_clkdiv(&c, div);
+    pio_sm_init(csync_pio, sm, offset, &c);
+    pio_sm_set_enabled(csync_pio, sm, true);
+}
+
+static void sync_set_inverted(uint pin, bool *inverted, bool value)
+{
+    *inverted = value;
+    gpio_set_inover(pin, value ? GPIO_OVERRIDE_INVERT : GPIO_OVERRIDE_NORMAL);
+}
+
+/**
+ * Flip an input's polarity and throw away everything measured the old way round
+ * A backlog can build up behind crt_task's i2c write, and each of those would otherwise flip it straight back
+ */
+static void sync_flip(uint pin, bool *inverted, uint sm, csync_filter *filter)
+{
+    sync_set_inverted(pin, inverted, !*inverted);
+    while (!pio_sm_is_rx_fifo_empty(csync_pio, sm)) {
+        pio_sm_get(csync_pio, sm);
+    }
+    csync_filter_reset(filter);
+}
+#endif
+
+/**
+ * Start measuring the incoming syncs and generating csync from them
+ * Everything timing critical happens in the PIO, the cpu just keeps its idea of polarity and line length up to date
+ */
+void csync_init(void) {
+#ifdef CSYNC_REGEN
+    gpio_init(HSYNC_PIN);
+    gpio_init(VSYNC_PIN);
+    sync_set_inverted(HSYNC_PIN, &hsync_inverted, hsync_inverted);
+    sync_set_inverted(VSYNC_PIN, &vsync_inverted, vsync_inverted);
+    csync_filter_reset(&hsync_filter);
+    csync_filter_reset(&vsync_filter);
+
+    uint measure_offset = pio_add_program(csync_pio, &sync_measure_program);
+    hsync_measure_sm = pio_claim_unused_sm(csync_pio, true);
+    vsync_measure_sm = pio_claim_unused_sm(csync_pio, true);
+    measure_sm_init(hsync_measure_sm, measure_offset, HSYNC_PIN, 1.0f);
+    measure_sm_init(vsync_measure_sm, measure_offset, VSYNC_PIN, VSYNC_MEASURE_DIV);
+
+    uint csync_offset = pio_add_program(csync_pio, &csync_program);
+    csync_sm = pio_claim_unused_sm(csync_pio, true);
+    pio_sm_config c = csync_program_get_default_config(csync_offset);
+    sm_config_set_in_pins(&c, HSYNC_PIN);
+    sm_config_set_jmp_pin(&c, VSYNC_PIN);
+    sm_config_set_out_pins(&c, CSYNC_PIN, 1);
+    sm_config_set_set_pins(&c, CSYNC_PIN, 1);
+    pio_gpio_init(csync_pio, CSYNC_PIN);
+    gpio_set_outover(CSYNC_PIN, GPIO_OVERRIDE_INVERT); // the program works active high, csync goes out active low
+    pio_sm_set_consecutive_pindirs(csync_pio, csync_sm, CSYNC_PIN, 1, true);
+    pio_sm_init(csync_pio, csync_sm, csync_offset, &c);
+    // give it a broad pulse length for a 15kHz line up front, or a vsync before the first measurement gets 0
+    csync_broad = csync_broad_cycles(0, CSYNC_DEFAULT_IDLE);
+    pio_sm_put(csync_pio, csync_sm, csync_broad);
+    pio_sm_set_enabled(csync_pio, csync_sm, true);
+#endif
+}
+
+/**
+ * Keep up with the measurements coming out of the PIO
+ * Flips an input's polarity if its sync pulse keeps looking longer than the gap between them, and hands any settled
+ * change in line length on to the csync program for its vsync broad pulses
+ */
+void csync_task(void) {
+#ifdef CSYNC_REGEN
+    while (!pio_sm_is_rx_fifo_empty(csync_pio, hsync_measure_sm)) {
+        uint32_t m = pio_sm_get(csync_pio, hsync_measure_sm);
+        uint32_t active = m & 0xFFFF;
+        uint32_t idle = m >> 16;
+
+        csync_action action = csync_filter_push(&hsync_filter, active, idle);
+        if (action == CSYNC_FLIP) {
+            sync_flip(HSYNC_PIN, &hsync_inverted, hsync_measure_sm, &hsync_filter);
+            break;
+        }
+        if (action != CSYNC_LINE) continue;
+
+        // measurements wobble by a count or so, no need to bother the PIO over that
+        uint32_t next = csync_broad_cycles(active, idle);
+        if ((next > csync_broad + 4 || next + 4 < csync_broad) && !pio_sm_is_tx_fifo_full(csync_pio, csync_sm)) {
+            pio_sm_put(csync_pio, csync_sm, next);
+            csync_broad = next;
+        }
+    }
+
+    while (!pio_sm_is_rx_fifo_empty(csync_pio, vsync_measure_sm)) {
+        uint32_t m = pio_sm_get(csync_pio, vsync_measure_sm);
+        if (csync_filter_push(&vsync_filter, m & 0xFFFF, m >> 16) == CSYNC_FLIP) {
+            sync_flip(VSYNC_PIN, &vsync_inverted, vsync_measure_sm, &vsync_filter);
+            break;
+        }
+    }
+#endif
+}
+
+/**
+ * sleep_ms(), but keeping csync_task() going the whole time
+ */
+void csync_wait_ms(uint32_t ms) {
+    absolute_time_t until = make_timeout_time_ms(ms);
+    while (!time_reached(until)) {
+        csync_task();
+    }
+}
+
 //--------------------------------------------------------------------+
 // Device callbacks
 //--------------------------------------------------------------------+